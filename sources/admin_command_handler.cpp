@@ -16,11 +16,9 @@ GNU General Public License for more details.
 #include <cryptopp/blake2.h>
 #include "utils.h"
 
-AdminCommandHandler::AdminCommandHandler(ServerList &serverList, 
-	ConfigManager &configManager, std::unordered_set<NetAddress, NetAddressHash> &banlist) :
+AdminCommandHandler::AdminCommandHandler(ServerList &serverList, ConfigManager &configManager) :
 	m_serverList(serverList),
-	m_configManager(configManager),
-	m_banlist(banlist)
+	m_configManager(configManager)
 {
 }
 
@@ -64,7 +62,7 @@ void AdminCommandHandler::HandleCommandRequest(const NetAddress &sourceAddr, Adm
 	Utils::Log("Unauthorized admin command attempt from {}:{}\n", sourceAddr.ToString(), sourceAddr.GetPort());
 }
 
-void AdminCommandHandler::HandleCommand(const NetAddress &sourceAddr, const std::string &name, const std::string &command)
+void AdminCommandHandler::HandleCommand(const NetAddress &sourceAddr, const std::string &name, std::string_view command)
 {
 	std::vector<std::string_view> tokens = Utils::Tokenize(command, " ");
 	if (tokens.size() == 2)
@@ -95,13 +93,12 @@ void AdminCommandHandler::HandleCommand(const NetAddress &sourceAddr, const std:
 
 void AdminCommandHandler::HandleBanCommand(const NetAddress &sourceAddr, const std::string &name, const NetAddress &targetAddr)
 {
-	m_banlist.insert(targetAddr);
 	m_serverList.BanAddress(targetAddr);
 	Utils::Log("Admin {}({}) banned address {}\n", name, sourceAddr.ToString(), targetAddr.ToString());
 }
 
 void AdminCommandHandler::HandleUnbanCommand(const NetAddress &sourceAddr, const std::string &name, const NetAddress &targetAddr)
 {
-	m_banlist.erase(targetAddr);
+	m_serverList.UnbanAddress(targetAddr);
 	Utils::Log("Admin {}({}) unbanned address {}\n", name, sourceAddr.ToString(), targetAddr.ToString());
 }
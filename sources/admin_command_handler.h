@@ -19,23 +19,19 @@ GNU General Public License for more details.
 #include "admin_challenge.h"
 #include "admin_command_request.h"
 #include <string>
-#include <unordered_set>
 
 class AdminCommandHandler
 {
 public:
-	AdminCommandHandler(ServerList &serverList, 
-		ConfigManager &configManager, 
-		std::unordered_set<NetAddress, NetAddressHash> &banlist);
+	AdminCommandHandler(ServerList &serverList, ConfigManager &configManager);
 
 	void HandleCommandRequest(const NetAddress &sourceAddr, AdminCommandRequest &request, AdminChallenge &challenge);
 
 private:
-	void HandleCommand(const NetAddress &sourceAddr, const std::string &name, const std::string &command);
+	void HandleCommand(const NetAddress &sourceAddr, const std::string &name, std::string_view command);
 	void HandleBanCommand(const NetAddress &sourceAddr, const std::string &name, const NetAddress &targetAddr);
 	void HandleUnbanCommand(const NetAddress &sourceAddr, const std::string &name, const NetAddress &targetAddr);
 
 	ServerList &m_serverList;
 	ConfigManager &m_configManager;
-	std::unordered_set<NetAddress, NetAddressHash> &m_banlist;
 };
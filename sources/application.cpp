@@ -16,6 +16,8 @@ GNU General Public License for more details.
 #include "build.h"
 #include "build_info.h"
 #include "utils.h"
+#include "packet_filter.h"
+#include "clock.h"
 #include <stdexcept>
 #include <cstdio>
 
@@ -24,7 +26,9 @@ GNU General Public License for more details.
 #endif
 
 Application::Application() :
-	m_argsParser("xash-ms", "1.0", argparse::default_arguments::help)
+	m_argsParser("xash-ms", "1.0", argparse::default_arguments::help),
+	m_workersCount(1),
+	m_ioBackendType(IoBackend::Type::Libevent)
 {
 }
 
@@ -58,6 +62,13 @@ int Application::Run(int argc, char *argv[])
 		return -1;
 	}
 
+	m_configManager = std::make_shared<ConfigManager>();
+	if (m_configManager->ParseConfig(m_argsParser.get<std::string>("--config-file"))) {
+		Utils::Log("Configuration file loaded\n");
+	}
+
+	InitializeWorkersCount();
+	InitializeIoBackendType();
 	if (m_argsParser.present("--ip")) {
 		InitializeSocketInet();
 	}
@@ -65,16 +76,10 @@ int Application::Run(int argc, char *argv[])
 		InitializeSocketInet6();
 	}
 
-	m_configManager = std::make_shared<ConfigManager>();
-	if (m_configManager->ParseConfig(m_argsParser.get<std::string>("--config-file"))) {
-		Utils::Log("Configuration file loaded\n");
-	}
-
-	if (m_socketInet || m_socketInet6) 
+	if (!m_socketsInet.empty() || !m_socketsInet6.empty()) 
 	{
 		Utils::Log("Starting listening for requests...\n");
-		m_eventLoop = std::make_unique<EventLoop>(m_socketInet, m_socketInet6, m_configManager);
-		m_eventLoop->Run();
+		RunEventLoops();
 		Utils::Log("Shutting down...\n");
 	}
 	else 
@@ -112,6 +117,15 @@ void Application::InitializeProgramArguments()
 	m_argsParser.add_argument("-ip6", "--ip6")
 		.help("address of IPv6 interface, which will be listened for incoming packets");
 
+	m_argsParser.add_argument("-w", "--workers")
+		.help("number of threads handling requests, each one gets own sockets bound with SO_REUSEPORT")
+		.default_value(1)
+		.scan<'d', int>();
+
+	m_argsParser.add_argument("-io", "--io-backend")
+		.help("I/O backend used for receiving packets: libevent or io_uring (Linux only)")
+		.default_value("libevent");
+
 	m_argsParser.add_argument("-u", "--unbuffered")
 		.help("force stdout and stderr streams to be unbuffered")
 		.flag();
@@ -121,6 +135,36 @@ void Application::InitializeProgramArguments()
 		.default_value("config.json");
 }
 
+void Application::InitializeWorkersCount()
+{
+	int workersCount = m_argsParser.get<int>("--workers");
+	if (workersCount < 1) 
+	{
+		Utils::Log("Invalid workers count {}, using single worker\n", workersCount);
+		workersCount = 1;
+	}
+#ifndef SO_REUSEPORT
+	if (workersCount > 1)
+	{
+		Utils::Log("SO_REUSEPORT is not supported on this platform, using single worker\n");
+		workersCount = 1;
+	}
+#endif
+	m_workersCount = workersCount;
+}
+
+void Application::InitializeIoBackendType()
+{
+	std::string backendName = m_argsParser.get<std::string>("--io-backend");
+	auto backendType = IoBackend::ParseType(backendName);
+	if (backendType.has_value()) {
+		m_ioBackendType = backendType.value();
+	}
+	else {
+		Utils::Log("Unknown I/O backend \"{}\", using libevent\n", backendName);
+	}
+}
+
 void Application::InitializeSocketInet()
 {
 	NetAddress address(NetAddress::AddressFamily::IPv4);
@@ -130,12 +174,13 @@ void Application::InitializeSocketInet()
 	if (address.FromString(addressString.c_str(), portNumber))
 	{
 		try {
-			m_socketInet = std::make_shared<Socket>(AF_INET, SOCK_DGRAM, 0);
-			m_socketInet->Bind(address);
+			for (size_t i = 0; i < m_workersCount; i++) {
+				m_socketsInet.push_back(CreateSocket(address));
+			}
 			Utils::Log("Server IPv4 address: {}:{}\n", address.ToString(), address.GetPort());
 		}
 		catch (const std::exception &ex) {
-			m_socketInet.reset();
+			m_socketsInet.clear();
 			Utils::Log("Failed to initialize IPv4 socket: {}\n", ex.what());
 		}
 	}
@@ -153,12 +198,13 @@ void Application::InitializeSocketInet6()
 	if (address.FromString(addressString.c_str(), portNumber)) 
 	{
 		try {
-			m_socketInet6 = std::make_shared<Socket>(AF_INET6, SOCK_DGRAM, 0);
-			m_socketInet6->Bind(address);
+			for (size_t i = 0; i < m_workersCount; i++) {
+				m_socketsInet6.push_back(CreateSocket(address));
+			}
 			Utils::Log("Server IPv6 address: [{}]:{}\n", address.ToString(), address.GetPort());
 		}
 		catch (const std::exception &ex) {
-			m_socketInet6.reset();
+			m_socketsInet6.clear();
 			Utils::Log("Failed to initialize IPv6 socket: {}\n", ex.what());
 		}
 	}
@@ -166,3 +212,121 @@ void Application::InitializeSocketInet6()
 		Utils::Log("Failed to parse IPv6 interface address\n");
 	}
 }
+
+std::shared_ptr<Socket> Application::CreateSocket(const NetAddress &address)
+{
+	const ConfigData &configData = m_configManager->GetData();
+	const int32_t addressFamily = (address.GetAddressFamily() == NetAddress::AddressFamily::IPv4) ? AF_INET : AF_INET6;
+	auto socket = std::make_shared<Socket>(addressFamily, SOCK_DGRAM, 0);
+	if (m_workersCount > 1) {
+		socket->EnableReusePort(); // kernel will distribute incoming packets between workers sockets
+	}
+	socket->Bind(address);
+	if (configData.GetPacketFilterEnabled()) 
+	{
+		// it's just an optimization, so work without filter if kernel refused it
+		try {
+			PacketFilter::CreateForRequests().Attach(*socket);
+		}
+		catch (const std::exception &ex) {
+			Utils::Log("Failed to attach packet filter: {}\n", ex.what());
+		}
+	}
+	socket->SetRecvBatchSize(configData.GetRecvBatchSize());
+	socket->SetSendBatchSize(configData.GetSendBatchSize());
+	return socket;
+}
+
+void Application::RunEventLoops()
+{
+	m_serverList = std::make_shared<ServerList>(*m_configManager);
+	InitializeSnapshotManager();
+	for (size_t i = 0; i < m_workersCount; i++)
+	{
+		const bool primary = (i == 0);
+		auto socketInet = m_socketsInet.empty() ? nullptr : m_socketsInet[i];
+		auto socketInet6 = m_socketsInet6.empty() ? nullptr : m_socketsInet6[i];
+		auto snapshotManager = primary ? m_snapshotManager : nullptr;
+		m_eventLoops.push_back(std::make_unique<EventLoop>(socketInet, socketInet6, m_configManager, m_serverList, snapshotManager, m_ioBackendType, primary));
+	}
+
+	if (m_workersCount > 1) {
+		Utils::Log("Running {} workers\n", m_workersCount);
+	}
+
+	// first loop runs on main thread and receives signals, so others have to be stopped after it
+	EventLoop *primaryLoop = m_eventLoops[0].get();
+	for (size_t i = 1; i < m_eventLoops.size(); i++) 
+	{
+		EventLoop *eventLoop = m_eventLoops[i].get();
+		m_workerThreads.emplace_back([eventLoop, primaryLoop, i]() {
+			try {
+				eventLoop->Run();
+			}
+			catch (const std::exception &ex) 
+			{
+				// exception escaping thread would terminate whole process, so shut down gracefully instead
+				Utils::Log("Worker {} failed: {}\n", i, ex.what());
+				primaryLoop->Stop();
+			}
+			catch (...) 
+			{
+				Utils::Log("Worker {} failed: unknown exception\n", i);
+				primaryLoop->Stop();
+			}
+		});
+	}
+
+	try {
+		primaryLoop->Run();
+	}
+	catch (...) 
+	{
+		// final snapshot is skipped intentionally: failed handler could leave list partially
+		// updated, and last periodic snapshot is better to load on restart than such state
+		StopWorkers();
+		throw;
+	}
+	StopWorkers();
+	SaveFinalSnapshot();
+}
+
+void Application::StopWorkers()
+{
+	for (size_t i = 1; i < m_eventLoops.size(); i++) {
+		m_eventLoops[i]->Stop();
+	}
+	for (auto &thread : m_workerThreads) {
+		thread.join();
+	}
+	m_workerThreads.clear();
+}
+
+void Application::InitializeSnapshotManager()
+{
+	const std::string &snapshotFile = m_configManager->GetData().GetSnapshotFile();
+	if (snapshotFile.empty()) {
+		return;
+	}
+
+	// loaded before any event loop is started, so clients get full list right away
+	m_snapshotManager = std::make_shared<SnapshotManager>(snapshotFile);
+	if (m_snapshotManager->Load(*m_serverList)) {
+		Utils::Log("Snapshot loaded: {} servers\n", m_serverList->GetEntriesCollection().size());
+	}
+}
+
+void Application::SaveFinalSnapshot()
+{
+	if (!m_snapshotManager) {
+		return;
+	}
+
+	Utils::Log("Saving snapshot...\n");
+	Clock::Update();
+	{
+		std::shared_lock lock(m_serverList->GetMutex());
+		m_snapshotManager->Save(m_serverList->TakeSnapshot());
+	}
+	m_snapshotManager.reset(); // waits until snapshot is written
+}
@@ -16,8 +16,12 @@ GNU General Public License for more details.
 #include <argparse/argparse.hpp>
 #include "socket.h"
 #include "event_loop.h"
+#include "server_list.h"
 #include "config_manager.h"
+#include "snapshot_manager.h"
 #include <memory>
+#include <vector>
+#include <thread>
 
 class Application
 {
@@ -28,12 +32,24 @@ public:
 private:
 	void PrintProgramTitle();
 	void InitializeProgramArguments();
+	void InitializeWorkersCount();
+	void InitializeIoBackendType();
 	void InitializeSocketInet();
 	void InitializeSocketInet6();
+	std::shared_ptr<Socket> CreateSocket(const NetAddress &address);
+	void RunEventLoops();
+	void StopWorkers();
+	void InitializeSnapshotManager();
+	void SaveFinalSnapshot();
 
 	argparse::ArgumentParser m_argsParser;
-	std::shared_ptr<Socket> m_socketInet;
-	std::shared_ptr<Socket> m_socketInet6;
+	size_t m_workersCount;
+	IoBackend::Type m_ioBackendType;
+	std::vector<std::shared_ptr<Socket>> m_socketsInet;
+	std::vector<std::shared_ptr<Socket>> m_socketsInet6;
 	std::shared_ptr<ConfigManager> m_configManager;
-	std::unique_ptr<EventLoop> m_eventLoop;
+	std::shared_ptr<ServerList> m_serverList;
+	std::shared_ptr<SnapshotManager> m_snapshotManager;
+	std::vector<std::unique_ptr<EventLoop>> m_eventLoops;
+	std::vector<std::thread> m_workerThreads;
 };
@@ -13,6 +13,7 @@ GNU General Public License for more details.
 */
 
 #include "binary_input_stream.h"
+#include "byte_scan.h"
 #include <algorithm>
 #include <cstring>
 
@@ -35,19 +36,33 @@ bool BinaryInputStream::SkipBytes(size_t count)
 	return false;
 }
 
+bool BinaryInputStream::ReadByteSpan(std::pair<const uint8_t*, size_t> &dest, size_t count)
+{
+	const uint8_t *data = Consume(count);
+	dest = std::make_pair(data, data ? count : 0);
+	return data != nullptr;
+}
+
+const uint8_t *BinaryInputStream::Consume(size_t count)
+{
+	size_t remainingBytes = m_bufferSize - m_currentOffset;
+	if (remainingBytes >= count) 
+	{
+		const uint8_t *data = m_bufferAddress + m_currentOffset;
+		m_currentOffset += count;
+		return data;
+	}
+	m_underflowFlag = true;
+	return nullptr;
+}
+
 bool BinaryInputStream::SkipString()
 {
 	size_t remainingBytes = m_bufferSize - m_currentOffset;
 	if (remainingBytes > 0)
 	{
-		for (size_t i = 0; i < remainingBytes; i++)
-		{
-			char character;
-			ReadData(&character, sizeof(character));
-			if (character == '\0') {
-				break;
-			}
-		}
+		const size_t length = FindStringLength();
+		m_currentOffset += std::min(length + 1, remainingBytes);
 		return true;
 	}
 	else {
@@ -58,25 +73,33 @@ bool BinaryInputStream::SkipString()
 
 bool BinaryInputStream::ReadString(std::string &dest)
 {
-	dest.clear();
-	dest.reserve(16);
 	size_t remainingBytes = m_bufferSize - m_currentOffset;
 	if (remainingBytes > 0)
 	{
-		for (size_t i = 0; i < remainingBytes; i++)
-		{
-			char character;
-			ReadData(&character, sizeof(character));
-			if (character != '\0') {
-				dest.push_back(character);
-			}
-			else {
-				break;
-			}
-		}
+		const size_t length = FindStringLength();
+		dest.assign(reinterpret_cast<const char*>(m_bufferAddress + m_currentOffset), length);
+		m_currentOffset += std::min(length + 1, remainingBytes);
 		return true;
 	}
 	else {
+		dest.clear();
+		m_underflowFlag = true;
+	}
+	return false;
+}
+
+bool BinaryInputStream::ReadStringView(std::string_view &dest)
+{
+	const size_t remainingBytes = m_bufferSize - m_currentOffset;
+	if (remainingBytes > 0)
+	{
+		const size_t length = FindStringLength();
+		dest = std::string_view(reinterpret_cast<const char*>(m_bufferAddress + m_currentOffset), length);
+		m_currentOffset += std::min(length + 1, remainingBytes);
+		return true;
+	}
+	else {
+		dest = std::string_view();
 		m_underflowFlag = true;
 	}
 	return false;
@@ -96,6 +119,31 @@ bool BinaryInputStream::ReadBytes(void *destBuffer, size_t count)
 	return false;
 }
 
+std::optional<NetAddress> BinaryInputStream::ReadNetAddress(NetAddress::AddressFamily family)
+{
+	// same format as BinaryOutputStream::WriteNetAddress, port is big endian
+	NetAddress address(family);
+	if (family == NetAddress::AddressFamily::IPv4) 
+	{
+		sockaddr_in sockaddr = {};
+		sockaddr.sin_family = AF_INET;
+		if (!ReadBytes(&sockaddr.sin_addr, 4) || !ReadBytes(&sockaddr.sin_port, 2)) {
+			return std::nullopt;
+		}
+		address.FromSockadr(&sockaddr);
+	}
+	else 
+	{
+		sockaddr_in6 sockaddr = {};
+		sockaddr.sin6_family = AF_INET6;
+		if (!ReadBytes(&sockaddr.sin6_addr, 16) || !ReadBytes(&sockaddr.sin6_port, 2)) {
+			return std::nullopt;
+		}
+		address.FromSockadr(&sockaddr);
+	}
+	return address;
+}
+
 bool BinaryInputStream::EndOfFile() const
 {
 	return (m_bufferSize - m_currentOffset) == 0;
@@ -123,3 +171,10 @@ size_t BinaryInputStream::ReadData(void *destBuffer, size_t count)
 	m_currentOffset += remainingBytes;
 	return remainingBytes;
 }
+
+size_t BinaryInputStream::FindStringLength() const
+{
+	// string without terminator takes all remaining bytes
+	const char *start = reinterpret_cast<const char*>(m_bufferAddress + m_currentOffset);
+	return ByteScan::FindByte(start, m_bufferSize - m_currentOffset, '\0');
+}
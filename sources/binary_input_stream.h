@@ -13,7 +13,11 @@ GNU General Public License for more details.
 */
 
 #pragma once
+#include "net_address.h"
 #include <string>
+#include <string_view>
+#include <optional>
+#include <utility>
 #include <stdint.h>
 #include <type_traits>
 
@@ -39,7 +43,11 @@ public:
 	bool SkipBytes(size_t count);
 	bool SkipString();
 	bool ReadString(std::string &dest);
+	bool ReadStringView(std::string_view &dest); // view points to stream buffer, there is no copying
 	bool ReadBytes(void *destBuffer, size_t count);
+	bool ReadByteSpan(std::pair<const uint8_t*, size_t> &dest, size_t count); // same as above, valid while buffer is alive
+	const uint8_t *Consume(size_t count); // returns pointer to skipped bytes, or nullptr if there is not enough of them
+	std::optional<NetAddress> ReadNetAddress(NetAddress::AddressFamily family);
 	bool EndOfFile() const;
 	bool Underflowed() const;
 	size_t GetBufferSize() const;
@@ -47,6 +55,7 @@ public:
 
 private:
 	size_t ReadData(void *destBuffer, size_t count);
+	size_t FindStringLength() const;
 
 	size_t m_bufferSize;
 	size_t m_currentOffset;
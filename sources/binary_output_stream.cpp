@@ -13,13 +13,18 @@ GNU General Public License for more details.
 */
 
 #include "binary_output_stream.h"
+#include <cassert>
 #include <cstring>
 
 BinaryOutputStream::BinaryOutputStream(std::vector<uint8_t> &buffer) :
 	m_buffer(nullptr),
 	m_offset(0),
 	m_bufferSize(0),
-	m_dynamicBuffer(buffer)
+	m_segmentStart(0),
+	m_referencedLength(0),
+	m_overflowFlag(false),
+	m_dynamicBuffer(buffer),
+	m_segments(std::nullopt)
 {
 	buffer.clear();
 }
@@ -28,10 +33,27 @@ BinaryOutputStream::BinaryOutputStream(uint8_t *buffer, size_t bufferSize) :
 	m_buffer(buffer),
 	m_offset(0),
 	m_bufferSize(bufferSize),
-	m_dynamicBuffer(std::nullopt)
+	m_segmentStart(0),
+	m_referencedLength(0),
+	m_overflowFlag(false),
+	m_dynamicBuffer(std::nullopt),
+	m_segments(std::nullopt)
 {
 }
 
+BinaryOutputStream::BinaryOutputStream(uint8_t *buffer, size_t bufferSize, std::vector<OutputSegment> &segments) :
+	m_buffer(buffer),
+	m_offset(0),
+	m_bufferSize(bufferSize),
+	m_segmentStart(0),
+	m_referencedLength(0),
+	m_overflowFlag(false),
+	m_dynamicBuffer(std::nullopt),
+	m_segments(segments)
+{
+	segments.clear();
+}
+
 const uint8_t *BinaryOutputStream::GetBuffer() const
 {
 	return m_dynamicBuffer.has_value() ? m_dynamicBuffer->get().data() : m_buffer;
@@ -39,7 +61,14 @@ const uint8_t *BinaryOutputStream::GetBuffer() const
 
 size_t BinaryOutputStream::GetLength() const
 {
-	return m_dynamicBuffer.has_value() ? m_dynamicBuffer->get().size() : m_offset;
+	return m_dynamicBuffer.has_value() ? m_dynamicBuffer->get().size() : m_offset + m_referencedLength;
+}
+
+const std::vector<OutputSegment> &BinaryOutputStream::GetSegments()
+{
+	assert(m_segments.has_value());
+	Finish();
+	return m_segments->get();
 }
 
 bool BinaryOutputStream::WriteString(const char *text, bool includeNull)
@@ -53,8 +82,8 @@ bool BinaryOutputStream::WriteBytes(const void *data, size_t count)
 	const uint8_t *sourceBuffer = reinterpret_cast<const uint8_t*>(data);
 	if (m_dynamicBuffer.has_value()) 
 	{
+		// no explicit reserve here, it would defeat geometric growth of vector
 		auto &dynamicBuffer = m_dynamicBuffer->get();
-		dynamicBuffer.reserve(dynamicBuffer.size() + count);
 		dynamicBuffer.insert(dynamicBuffer.end(), sourceBuffer, sourceBuffer + count);
 		return true;
 	}
@@ -67,6 +96,7 @@ bool BinaryOutputStream::WriteBytes(const void *data, size_t count)
 			return true;
 		}
 	}
+	m_overflowFlag = true;
 	return false;
 }
 
@@ -75,7 +105,6 @@ bool BinaryOutputStream::WriteByte(uint8_t value, size_t repeats)
 	if (m_dynamicBuffer.has_value()) 
 	{
 		auto &dynamicBuffer = m_dynamicBuffer->get();
-		dynamicBuffer.reserve(dynamicBuffer.size() + repeats);
 		dynamicBuffer.insert(dynamicBuffer.end(), repeats, value);
 		return true;
 	}
@@ -88,6 +117,7 @@ bool BinaryOutputStream::WriteByte(uint8_t value, size_t repeats)
 			return true;
 		}
 	}
+	m_overflowFlag = true;
 	return false;
 }
 
@@ -98,3 +128,28 @@ bool BinaryOutputStream::WriteNetAddress(const NetAddress &address)
 	WriteByte((address.GetPort() >> 8) & 0xFF); // write port number as big endian 16-bit integer
 	return WriteByte(address.GetPort() & 0xFF);
 }
+
+bool BinaryOutputStream::WriteReference(const void *data, size_t count)
+{
+	if (!m_segments.has_value()) {
+		return WriteBytes(data, count);
+	}
+
+	Finish();
+	if (count > 0) 
+	{
+		m_segments->get().push_back({ reinterpret_cast<const uint8_t*>(data), count });
+		m_referencedLength += count;
+	}
+	return true;
+}
+
+void BinaryOutputStream::Finish()
+{
+	// bytes written since previous reference become separate segment
+	if (m_segments.has_value() && m_offset > m_segmentStart) 
+	{
+		m_segments->get().push_back({ m_buffer + m_segmentStart, m_offset - m_segmentStart });
+		m_segmentStart = m_offset;
+	}
+}
@@ -19,18 +19,31 @@ GNU General Public License for more details.
 #include <functional>
 #include <stdint.h>
 
+// piece of output data, either written into stream buffer or just referenced by it
+struct OutputSegment
+{
+	const uint8_t *data;
+	size_t size;
+};
+
 class BinaryOutputStream
 {
 public:
 	BinaryOutputStream(std::vector<uint8_t> &buffer);
 	BinaryOutputStream(uint8_t *buffer, size_t bufferSize);
+	// in such mode referenced data isn't copied, and output is described by list of segments
+	BinaryOutputStream(uint8_t *buffer, size_t bufferSize, std::vector<OutputSegment> &segments);
 
-	const uint8_t *GetBuffer() const;
+	const uint8_t *GetBuffer() const; // doesn't include referenced data
 	size_t GetLength() const;
+	const std::vector<OutputSegment> &GetSegments(); // only for streams constructed with segments list
+	void Finish(); // makes bytes written after last reference a segment too
+	bool Overflowed() const { return m_overflowFlag; }
 	bool WriteString(const char *text, bool includeNull = false);
 	bool WriteBytes(const void *data, size_t count);
 	bool WriteByte(uint8_t value, size_t repeats = 1);
 	bool WriteNetAddress(const NetAddress &address);
+	bool WriteReference(const void *data, size_t count); // data should stay alive until output is consumed
 
 	template<class T> bool Write(const T& value) 
 	{
@@ -42,5 +55,9 @@ private:
 	uint8_t *m_buffer;
 	size_t m_offset;
 	size_t m_bufferSize;
+	size_t m_segmentStart;
+	size_t m_referencedLength;
+	bool m_overflowFlag;
 	std::optional<std::reference_wrapper<std::vector<uint8_t>>> m_dynamicBuffer; // maybe just use pointer? no.
+	std::optional<std::reference_wrapper<std::vector<OutputSegment>>> m_segments;
 };
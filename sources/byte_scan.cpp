@@ -0,0 +1,160 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "byte_scan.h"
+#include "cpu_features.h"
+#include <stdint.h>
+
+#if CPU_X86 == 1
+#include <immintrin.h>
+#elif CPU_NEON == 1
+#include <arm_neon.h>
+#endif
+
+static size_t LowestBitIndex(uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(mask);
+#else
+	size_t index = 0;
+	while ((mask & 1) == 0) 
+	{
+		mask >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+// every function checks only whole vectors from offset and returns either position 
+// of found byte, or offset where it stopped, so remaining tail is checked by next one
+static size_t FindByteScalar(const char *data, size_t size, size_t offset, char value)
+{
+	for (; offset < size; offset++) 
+	{
+		if (data[offset] == value) {
+			return offset;
+		}
+	}
+	return size;
+}
+
+#if CPU_SSE2 == 1
+static size_t FindByteSse2(const char *data, size_t size, size_t offset, char value, bool &found)
+{
+	const __m128i pattern = _mm_set1_epi8(value);
+	for (; offset + 16 <= size; offset += 16)
+	{
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+		const uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern));
+		if (mask != 0) 
+		{
+			found = true;
+			return offset + LowestBitIndex(mask);
+		}
+	}
+	return offset;
+}
+#endif
+
+#if CPU_X86 == 1
+CPU_TARGET_AVX2 static size_t FindByteAvx2(const char *data, size_t size, size_t offset, char value, bool &found)
+{
+	const __m256i pattern = _mm256_set1_epi8(value);
+	for (; offset + 32 <= size; offset += 32)
+	{
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + offset));
+		const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, pattern)));
+		if (mask != 0) 
+		{
+			found = true;
+			return offset + LowestBitIndex(mask);
+		}
+	}
+	return offset;
+}
+#endif
+
+#if CPU_NEON == 1
+static size_t FindByteNeon(const char *data, size_t size, size_t offset, char value, bool &found)
+{
+	const uint8x16_t pattern = vdupq_n_u8(static_cast<uint8_t>(value));
+	for (; offset + 16 <= size; offset += 16)
+	{
+		const uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(data + offset));
+		const uint8x16_t matches = vceqq_u8(chunk, pattern);
+		// there is no movemask in NEON, so every byte of result is narrowed to 4 bits of mask
+		const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+		if (mask != 0) 
+		{
+			found = true;
+			return offset + LowestBitIndex(mask) / 4;
+		}
+	}
+	return offset;
+}
+#endif
+
+// checks bytes from offset with 16-byte vectors where possible, and the rest one by one
+static size_t FindByteTail(const char *data, size_t size, size_t offset, char value)
+{
+#if CPU_SSE2 == 1
+	bool found = false;
+	offset = FindByteSse2(data, size, offset, value, found);
+	if (found) {
+		return offset;
+	}
+#elif CPU_NEON == 1
+	bool found = false;
+	offset = FindByteNeon(data, size, offset, value, found);
+	if (found) {
+		return offset;
+	}
+#endif
+	return FindByteScalar(data, size, offset, value); // remaining bytes that don't fill whole vector
+}
+
+static size_t SearchBaseline(const char *data, size_t size, char value)
+{
+	return FindByteTail(data, size, 0, value);
+}
+
+#if CPU_X86 == 1
+static size_t SearchAvx2(const char *data, size_t size, char value)
+{
+	bool found = false;
+	const size_t offset = FindByteAvx2(data, size, 0, value, found);
+	return found ? offset : FindByteTail(data, size, offset, value);
+}
+#endif
+
+using SearchFunction = size_t (*)(const char *data, size_t size, char value);
+
+static SearchFunction SelectSearchFunction()
+{
+#if CPU_X86 == 1
+	if (CpuFeatures::HasAvx2()) {
+		return SearchAvx2;
+	}
+#endif
+	return SearchBaseline;
+}
+
+// CPU features don't change while program is running, so implementation is selected once
+static const SearchFunction g_searchFunction = SelectSearchFunction();
+
+size_t ByteScan::FindByte(const char *data, size_t size, char value)
+{
+	return g_searchFunction(data, size, value);
+}
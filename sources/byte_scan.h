@@ -0,0 +1,23 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include <stddef.h>
+
+// searching of delimiters in packets text, 16 or 32 bytes are checked at once when CPU allows it
+namespace ByteScan
+{
+	// returns position of first occurrence of value, or size when it's not found
+	size_t FindByte(const char *data, size_t size, char value);
+}
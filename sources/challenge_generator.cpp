@@ -0,0 +1,122 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "challenge_generator.h"
+#include "clock.h"
+#include <cryptopp/siphash.h>
+#include <event2/util.h>
+#include <algorithm>
+#include <cstring>
+
+ChallengeGenerator::ChallengeGenerator()
+{
+	for (Secret &secret : m_secrets) {
+		secret.bucket = -1; // will be generated when needed
+	}
+}
+
+uint32_t ChallengeGenerator::GenerateServerChallenge(const NetAddress &address, int64_t lifetime)
+{
+	const int64_t bucket = GetCurrentBucket(lifetime);
+	return static_cast<uint32_t>(Calculate(*FindSecret(bucket), address, Purpose::Server));
+}
+
+bool ChallengeGenerator::ValidateServerChallenge(const NetAddress &address, uint32_t challenge, int64_t lifetime)
+{
+	const int64_t bucket = GetCurrentBucket(lifetime);
+	for (int64_t i = bucket; i >= bucket - 1; i--)
+	{
+		const Secret *secret = FindSecret(i);
+		if (secret && static_cast<uint32_t>(Calculate(*secret, address, Purpose::Server)) == challenge) {
+			return true;
+		}
+	}
+	return false;
+}
+
+AdminChallenge ChallengeGenerator::GenerateAdminChallenge(const NetAddress &address, int64_t lifetime)
+{
+	const int64_t bucket = GetCurrentBucket(lifetime);
+	const uint64_t value = Calculate(*FindSecret(bucket), address, Purpose::Admin);
+
+	AdminChallenge challenge;
+	challenge.master = static_cast<uint32_t>(value);
+	challenge.hash = static_cast<uint32_t>(value >> 32);
+	return challenge;
+}
+
+std::optional<AdminChallenge> ChallengeGenerator::ValidateAdminChallenge(const NetAddress &address, uint32_t master, int64_t lifetime)
+{
+	const int64_t bucket = GetCurrentBucket(lifetime);
+	for (int64_t i = bucket; i >= bucket - 1; i--)
+	{
+		const Secret *secret = FindSecret(i);
+		if (!secret) {
+			continue;
+		}
+
+		// hash salt is needed for command validation, and it's taken from same bucket as master challenge
+		const uint64_t value = Calculate(*secret, address, Purpose::Admin);
+		if (static_cast<uint32_t>(value) == master) 
+		{
+			AdminChallenge challenge;
+			challenge.master = master;
+			challenge.hash = static_cast<uint32_t>(value >> 32);
+			return challenge;
+		}
+	}
+	return std::nullopt;
+}
+
+int64_t ChallengeGenerator::GetCurrentBucket(int64_t lifetime)
+{
+	const int64_t bucket = Clock::GetTicks() / std::max<int64_t>(lifetime, 1);
+	Secret &secret = m_secrets[bucket & 1];
+	if (secret.bucket != bucket) 
+	{
+		// secret of bucket before previous one is overwritten, so its challenges are expired
+		secret.bucket = bucket;
+		evutil_secure_rng_get_bytes(secret.key, sizeof(secret.key));
+	}
+	return bucket;
+}
+
+const ChallengeGenerator::Secret *ChallengeGenerator::FindSecret(int64_t bucket) const
+{
+	const Secret &secret = m_secrets[bucket & 1];
+	return (secret.bucket == bucket) ? &secret : nullptr;
+}
+
+uint64_t ChallengeGenerator::Calculate(const Secret &secret, const NetAddress &address, Purpose purpose) const
+{
+	auto [addrData, addrSize] = address.GetAddressSpan();
+	const uint16_t port = address.GetPort();
+	uint8_t message[32];
+	size_t length = 0;
+
+	message[length++] = static_cast<uint8_t>(purpose);
+	message[length++] = static_cast<uint8_t>(addrSize);
+	std::memcpy(message + length, &port, sizeof(port));
+	length += sizeof(port);
+	std::memcpy(message + length, addrData, addrSize);
+	length += addrSize;
+	std::memcpy(message + length, &secret.bucket, sizeof(secret.bucket));
+	length += sizeof(secret.bucket);
+
+	uint64_t digest;
+	CryptoPP::SipHash<2, 4, false> mac(secret.key, sizeof(secret.key));
+	mac.Update(message, length);
+	mac.Final(reinterpret_cast<uint8_t*>(&digest));
+	return digest;
+}
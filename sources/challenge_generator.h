@@ -0,0 +1,53 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "net_address.h"
+#include "admin_challenge.h"
+#include <array>
+#include <optional>
+#include <stdint.h>
+
+// challenges which are not stored anywhere: value is MAC of source address and time bucket,
+// so it's just calculated again for validation. secret key is replaced every bucket, and
+// challenges from previous bucket are still accepted, so lifetime is between one and two buckets
+class ChallengeGenerator
+{
+public:
+	ChallengeGenerator();
+
+	uint32_t GenerateServerChallenge(const NetAddress &address, int64_t lifetime);
+	bool ValidateServerChallenge(const NetAddress &address, uint32_t challenge, int64_t lifetime);
+	AdminChallenge GenerateAdminChallenge(const NetAddress &address, int64_t lifetime);
+	std::optional<AdminChallenge> ValidateAdminChallenge(const NetAddress &address, uint32_t master, int64_t lifetime);
+
+private:
+	enum class Purpose : uint8_t
+	{
+		Server,
+		Admin
+	};
+
+	struct Secret
+	{
+		int64_t bucket;
+		uint8_t key[16];
+	};
+
+	int64_t GetCurrentBucket(int64_t lifetime);
+	const Secret *FindSecret(int64_t bucket) const;
+	uint64_t Calculate(const Secret &secret, const NetAddress &address, Purpose purpose) const;
+
+	std::array<Secret, 2> m_secrets; // indexed by bucket parity
+};
@@ -0,0 +1,63 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "clock.h"
+#include "build.h"
+#include <chrono>
+#if BUILD_LINUX == 1
+#include <time.h>
+#endif
+
+static Clock::TimeSource g_timeSource = nullptr; // plain pointer, it only changes before threads are started
+
+// every event loop thread has its own cached value, sampled when callback is started.
+// threads which never called Update() are reading clock directly
+static thread_local int64_t t_cachedTicks = 0;
+static thread_local bool t_cacheValid = false;
+
+int64_t Clock::GetTicks()
+{
+	if (t_cacheValid) {
+		return t_cachedTicks;
+	}
+	return ReadSystemTicks();
+}
+
+void Clock::Update()
+{
+	t_cachedTicks = ReadSystemTicks();
+	t_cacheValid = true;
+}
+
+void Clock::SetTimeSource(TimeSource source)
+{
+	g_timeSource = source;
+}
+
+int64_t Clock::ReadSystemTicks()
+{
+	if (g_timeSource) {
+		return g_timeSource();
+	}
+
+#if BUILD_LINUX == 1
+	// coarse clock doesn't need to read hardware counter, millisecond precision is enough here
+	timespec ts;
+	if (clock_gettime(CLOCK_MONOTONIC_COARSE, &ts) == 0) {
+		return static_cast<int64_t>(ts.tv_sec) * TicksPerSecond + ts.tv_nsec / (1000000000 / TicksPerSecond);
+	}
+#endif
+	auto duration = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
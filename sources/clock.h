@@ -0,0 +1,37 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include <stdint.h>
+
+// monotonic clock in integer milliseconds. reading it in hot paths (every packet, every
+// expiration check) is just load of value which was sampled once at event callback entry
+class Clock
+{
+public:
+	using TimeSource = int64_t(*)();
+	static constexpr int64_t TicksPerSecond = 1000;
+
+	static int64_t GetTicks();
+	static void Update();
+	// for tests, nullptr restores system clock. it isn't synchronized, so it should be
+	// set before event loops are started
+	static void SetTimeSource(TimeSource source);
+
+	static int64_t SecondsToTicks(double seconds) { return static_cast<int64_t>(seconds * TicksPerSecond); }
+	static double TicksToSeconds(int64_t ticks) { return static_cast<double>(ticks) / TicksPerSecond; }
+
+private:
+	static int64_t ReadSystemTicks();
+};
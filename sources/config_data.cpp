@@ -15,10 +15,18 @@ GNU General Public License for more details.
 #include "config_data.h"
 #include <rapidjson/rapidjson.h>
 #include <rapidjson/document.h>
+#include <algorithm>
 
 ConfigData::ConfigData() :
 	m_serverCountQuota(14),
 	m_adminHashLength(64),
+	m_recvBatchSize(32),
+	m_recvBudget(256),
+	m_sendBatchSize(64),
+	m_packetFilterEnabled(false),
+	m_maxResponseSize(1400),
+	m_statelessChallenges(false),
+	m_snapshotInterval(60.0f),
 	m_cleanupInterval(10.0f),
 	m_serverTimeoutInterval(360.0f),
 	m_challengeTimeoutInterval(15.0f),
@@ -104,5 +112,31 @@ bool ConfigData::Parse(const std::string &jsonData)
 	m_challengeTimeoutInterval = document["challenge_timeout_interval"].GetFloat();
 	m_adminHashKey = document["admin_hash_key"].GetString();
 	m_adminHashPersonal = document["admin_hash_personal"].GetString();
+
+	// optional parameters, default values are kept if they're missing
+	if (document.HasMember("recv_batch_size") && document["recv_batch_size"].IsInt()) {
+		m_recvBatchSize = std::max(document["recv_batch_size"].GetInt(), 1);
+	}
+	if (document.HasMember("recv_budget") && document["recv_budget"].IsInt()) {
+		m_recvBudget = std::max(document["recv_budget"].GetInt(), 1);
+	}
+	if (document.HasMember("send_batch_size") && document["send_batch_size"].IsInt()) {
+		m_sendBatchSize = std::max(document["send_batch_size"].GetInt(), 1);
+	}
+	if (document.HasMember("packet_filter") && document["packet_filter"].IsBool()) {
+		m_packetFilterEnabled = document["packet_filter"].GetBool();
+	}
+	if (document.HasMember("max_response_size") && document["max_response_size"].IsInt()) {
+		m_maxResponseSize = std::max(document["max_response_size"].GetInt(), 128);
+	}
+	if (document.HasMember("stateless_challenges") && document["stateless_challenges"].IsBool()) {
+		m_statelessChallenges = document["stateless_challenges"].GetBool();
+	}
+	if (document.HasMember("snapshot_file") && document["snapshot_file"].IsString()) {
+		m_snapshotFile = document["snapshot_file"].GetString();
+	}
+	if (document.HasMember("snapshot_interval") && document["snapshot_interval"].IsNumber()) {
+		m_snapshotInterval = std::max(document["snapshot_interval"].GetFloat(), 1.0f);
+	}
 	return true;
 }
@@ -39,6 +39,14 @@ public:
 	float GetServerTimeoutInterval() const { return m_serverTimeoutInterval; }
 	float GetChallengeTimeoutInterval() const { return m_challengeTimeoutInterval; }
 	size_t GetAdminHashLength() const { return m_adminHashLength; }
+	size_t GetRecvBatchSize() const { return m_recvBatchSize; }
+	size_t GetRecvBudget() const { return m_recvBudget; }
+	size_t GetSendBatchSize() const { return m_sendBatchSize; }
+	bool GetPacketFilterEnabled() const { return m_packetFilterEnabled; }
+	size_t GetMaxResponseSize() const { return m_maxResponseSize; }
+	bool GetStatelessChallenges() const { return m_statelessChallenges; }
+	const std::string& GetSnapshotFile() const { return m_snapshotFile; }
+	float GetSnapshotInterval() const { return m_snapshotInterval; }
 	const std::string& GetAdminHashKey() const { return m_adminHashKey; }
 	const std::string& GetAdminHashPersonal() const { return m_adminHashPersonal; }
 	const std::vector<AdminEntry>& GetAdmins() const { return m_adminsList; }
@@ -48,11 +56,19 @@ public:
 private:
 	size_t m_serverCountQuota;
 	size_t m_adminHashLength;
+	size_t m_recvBatchSize;
+	size_t m_recvBudget;
+	size_t m_sendBatchSize;
+	bool m_packetFilterEnabled;
+	size_t m_maxResponseSize;
+	bool m_statelessChallenges;
+	float m_snapshotInterval;
 	float m_cleanupInterval;
 	float m_serverTimeoutInterval;
 	float m_challengeTimeoutInterval;
 	std::string m_adminHashKey;
 	std::string m_adminHashPersonal;
+	std::string m_snapshotFile;
 	std::vector<AdminEntry> m_adminsList;
 	VersionInfo m_serverMinimalVersion;
 	VersionInfo m_clientMinimalVersion;
@@ -0,0 +1,53 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "cpu_features.h"
+
+#if (CPU_X86 == 1) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+static bool DetectAvx2()
+{
+#if CPU_X86 == 1
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	const bool osUsesXsave = (info[2] & (1 << 27)) != 0;
+	const bool avxSupported = (info[2] & (1 << 28)) != 0;
+	if (!osUsesXsave || !avxSupported) {
+		return false;
+	}
+	if ((_xgetbv(0) & 0x6) != 0x6) {
+		return false; // OS doesn't save YMM registers state
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return false;
+#endif
+#else
+	return false;
+#endif
+}
+
+bool CpuFeatures::HasAvx2()
+{
+	static const bool supported = DetectAvx2();
+	return supported;
+}
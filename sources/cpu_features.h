@@ -0,0 +1,40 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "build.h"
+
+#if (BUILD_AMD64 == 1) || (BUILD_X86 == 1)
+#define CPU_X86 1
+#endif
+
+#if (CPU_X86 == 1) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define CPU_SSE2 1 // baseline instruction set of target, no need to check it in runtime
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define CPU_NEON 1 // mandatory for AArch64, so it's also checked at compile time only
+#endif
+
+// functions with AVX2 code are compiled separately from the rest, and called only when CPU supports it
+#if (CPU_X86 == 1) && (defined(__GNUC__) || defined(__clang__))
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CPU_TARGET_AVX2
+#endif
+
+namespace CpuFeatures
+{
+	bool HasAvx2();
+}
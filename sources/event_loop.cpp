@@ -16,72 +16,122 @@ GNU General Public License for more details.
 #include "request_handler.h"
 #include "server_list.h"
 #include "libevent_wrappers.h"
+#include "utils.h"
+#include "clock.h"
+#include "timer.h"
 #include <event2/util.h>
 #include <iostream>
+#include <vector>
+#include <atomic>
+#include <mutex>
 #include <csignal>
+#include <stdexcept>
+
+static constexpr double StatisticsLogInterval = 300.0; // seconds
 
 struct EventLoop::Impl
 {
 public:
 	Impl(std::shared_ptr<Socket> socketInet, 
 		std::shared_ptr<Socket> socketInet6, 
-		std::shared_ptr<ConfigManager> configManager);
+		std::shared_ptr<ConfigManager> configManager,
+		std::shared_ptr<ServerList> serverList,
+		std::shared_ptr<SnapshotManager> snapshotManager,
+		IoBackend::Type ioBackendType,
+		bool primary);
+	~Impl();
 
 	void Run();
-	void RecvInetCallback();
-	void RecvInet6Callback();
+	void Stop();
 	void CleanupTimerCallback();
 	void SecondTimerCallback();
+	void SnapshotTimerCallback();
 
 private:
-	void InitInetSocketEvent();
-	void InitInet6SocketEvent();
+	void InitIoBackend(IoBackend::Type type);
 	void InitCleanupTimerEvent();
 	void InitSecondTimerEvent();
+	void InitSnapshotTimerEvent();
 	void InitSignalsEvents();
+	void InitWakeupEvent();
+	void LogStatistics() const;
+	void LogSocketStatistics(const char *name, const Socket &socket) const;
+	void LogRequestStatistics() const;
 
 	std::shared_ptr<Socket> m_socketInet;
 	std::shared_ptr<Socket> m_socketInet6;
 	std::shared_ptr<ConfigManager> m_configManager;
-	std::unique_ptr<ServerList> m_serverList;
+	std::shared_ptr<ServerList> m_serverList;
+	std::shared_ptr<SnapshotManager> m_snapshotManager;
 	std::unique_ptr<RequestHandler> m_requestHandler;
 	std::unique_ptr<ev::EventBase> m_eventBase;
-	std::unique_ptr<ev::Event> m_receivePacketInetEvent;
-	std::unique_ptr<ev::Event> m_receivePacketInet6Event;
+	std::unique_ptr<IoBackend> m_ioBackend;
 	std::unique_ptr<ev::Event> m_cleanupTimerEvent;
 	std::unique_ptr<ev::Event> m_secondTimerEvent;
+	std::unique_ptr<ev::Event> m_snapshotTimerEvent;
 	std::unique_ptr<ev::Event> m_sigtermSignalEvent;
 	std::unique_ptr<ev::Event> m_sigintSignalEvent;
+	std::unique_ptr<ev::Event> m_wakeupEvent;
+	Timer m_statisticsTimer;
+	evutil_socket_t m_wakeupSockets[2]; // writing to second one wakes up loop from another thread
+	std::atomic<bool> m_stopRequested;
 };
 
 EventLoop::Impl::Impl(std::shared_ptr<Socket> socketInet, 
 	std::shared_ptr<Socket> socketInet6,
-	std::shared_ptr<ConfigManager> configManager) :
+	std::shared_ptr<ConfigManager> configManager,
+	std::shared_ptr<ServerList> serverList,
+	std::shared_ptr<SnapshotManager> snapshotManager,
+	IoBackend::Type ioBackendType,
+	bool primary) :
 	m_socketInet(socketInet),
 	m_socketInet6(socketInet6),
 	m_configManager(configManager),
-	m_serverList(std::make_unique<ServerList>(*configManager)),
+	m_serverList(serverList),
+	m_snapshotManager(snapshotManager),
 	m_requestHandler(std::make_unique<RequestHandler>(*m_serverList, *configManager)),
-	m_eventBase(std::make_unique<ev::EventBase>())
+	m_eventBase(std::make_unique<ev::EventBase>()),
+	m_wakeupSockets{ EVUTIL_INVALID_SOCKET, EVUTIL_INVALID_SOCKET },
+	m_stopRequested(false)
 {
 	evutil_secure_rng_init();
-	if (socketInet) {
-		InitInetSocketEvent();
-	}
-	if (socketInet6) {
-		InitInet6SocketEvent();
-	}
+	InitIoBackend(ioBackendType);
+	InitWakeupEvent();
 
-	InitCleanupTimerEvent();
+	// libevent allows only one event base to handle signals,
+	// and it's enough to clean up shared list from single thread
+	if (primary) 
+	{
+		InitCleanupTimerEvent();
+		InitSignalsEvents();
+		if (m_snapshotManager) {
+			InitSnapshotTimerEvent();
+		}
+	}
 	InitSecondTimerEvent();
-	InitSignalsEvents();
+	m_statisticsTimer.Reset();
+}
+
+EventLoop::Impl::~Impl()
+{
+	m_wakeupEvent.reset();
+	for (evutil_socket_t socket : m_wakeupSockets) 
+	{
+		if (socket != EVUTIL_INVALID_SOCKET) {
+			evutil_closesocket(socket);
+		}
+	}
 }
 
 EventLoop::EventLoop(std::shared_ptr<Socket> socketInet, 
 	std::shared_ptr<Socket> socketInet6, 
-	std::shared_ptr<ConfigManager> configManager)
+	std::shared_ptr<ConfigManager> configManager,
+	std::shared_ptr<ServerList> serverList,
+	std::shared_ptr<SnapshotManager> snapshotManager,
+	IoBackend::Type ioBackendType,
+	bool primary)
 {
-	m_impl = std::make_unique<Impl>(socketInet, socketInet6, configManager);
+	m_impl = std::make_unique<Impl>(socketInet, socketInet6, configManager, serverList, snapshotManager, ioBackendType, primary);
 }
 
 EventLoop::~EventLoop()
@@ -93,43 +143,41 @@ void EventLoop::Run()
 	m_impl->Run();
 }
 
+void EventLoop::Stop()
+{
+	m_impl->Stop();
+}
+
 void EventLoop::Impl::Run()
 {
 	m_eventBase->Dispatch();
+	LogStatistics();
 }
 
-void EventLoop::Impl::InitInetSocketEvent()
+void EventLoop::Impl::Stop()
 {
-	auto inetRecvCallback = [](evutil_socket_t fd, short event, void *arg) {
-		EventLoop::Impl *impl = reinterpret_cast<EventLoop::Impl*>(arg);
-		impl->RecvInetCallback();
-	};
-
-	m_receivePacketInetEvent = std::make_unique<ev::Event>(
-		*m_eventBase, 
-		m_socketInet->GetDescriptor(),
-		EV_READ | EV_PERSIST,
-		inetRecvCallback,
-		this
-	);
-	m_receivePacketInetEvent->Add();
+	// event base can't be safely touched from another thread, so loop is woken up through
+	// socket pair and exits by itself, second timer checks the flag as well just in case
+	m_stopRequested = true;
+	const char signal = 0;
+	send(m_wakeupSockets[1], &signal, sizeof(signal), 0);
 }
 
-void EventLoop::Impl::InitInet6SocketEvent()
+void EventLoop::Impl::InitIoBackend(IoBackend::Type type)
 {
-	auto inet6RecvCallback = [](evutil_socket_t fd, short event, void *arg) {
-		EventLoop::Impl *impl = reinterpret_cast<EventLoop::Impl*>(arg);
-		impl->RecvInet6Callback();
-	};
+	std::vector<std::shared_ptr<Socket>> sockets;
+	if (m_socketInet) {
+		sockets.push_back(m_socketInet);
+	}
+	if (m_socketInet6) {
+		sockets.push_back(m_socketInet6);
+	}
 
-	m_receivePacketInet6Event = std::make_unique<ev::Event>(
-		*m_eventBase,
-		m_socketInet6->GetDescriptor(),
-		EV_READ | EV_PERSIST,
-		inet6RecvCallback,
-		this
-	);
-	m_receivePacketInet6Event->Add();
+	m_ioBackend = IoBackend::Create(type, 
+		*m_eventBase, 
+		*m_requestHandler, 
+		m_configManager->GetData(), 
+		sockets);
 }
 
 void EventLoop::Impl::InitCleanupTimerEvent()
@@ -139,7 +187,7 @@ void EventLoop::Impl::InitCleanupTimerEvent()
 		impl->CleanupTimerCallback();
 	};
 
-	timeval timerInterval = { m_configManager->GetData().GetCleanupInterval(), 0};
+	timeval timerInterval = { static_cast<time_t>(m_configManager->GetData().GetCleanupInterval()), 0 };
 	m_cleanupTimerEvent = std::make_unique<ev::Event>(
 		*m_eventBase, 
 		-1, 
@@ -168,6 +216,57 @@ void EventLoop::Impl::InitSecondTimerEvent()
 	m_secondTimerEvent->Add(&timerInterval);
 }
 
+void EventLoop::Impl::InitSnapshotTimerEvent()
+{
+	auto timerCallback = [](evutil_socket_t fd, short event, void *arg) {
+		EventLoop::Impl *impl = reinterpret_cast<EventLoop::Impl*>(arg);
+		impl->SnapshotTimerCallback();
+	};
+
+	timeval timerInterval = { static_cast<time_t>(m_configManager->GetData().GetSnapshotInterval()), 0 };
+	m_snapshotTimerEvent = std::make_unique<ev::Event>(
+		*m_eventBase, 
+		-1, 
+		EV_PERSIST, 
+		timerCallback, 
+		this
+	);
+	m_snapshotTimerEvent->Add(&timerInterval);
+}
+
+void EventLoop::Impl::InitWakeupEvent()
+{
+#if BUILD_WIN32 == 1
+	const int family = AF_INET; // emulated by libevent with loopback connection
+#else
+	const int family = AF_UNIX;
+#endif
+	if (evutil_socketpair(family, SOCK_STREAM, 0, m_wakeupSockets) != 0) {
+		throw std::runtime_error("failed to create event loop wakeup socket pair");
+	}
+	evutil_make_socket_nonblocking(m_wakeupSockets[0]);
+	evutil_make_socket_nonblocking(m_wakeupSockets[1]);
+
+	auto wakeupCallback = [](evutil_socket_t fd, short event, void *arg) {
+		EventLoop::Impl *impl = reinterpret_cast<EventLoop::Impl*>(arg);
+		char buffer[16];
+		while (recv(fd, buffer, sizeof(buffer), 0) > 0) {
+		}
+		if (impl->m_stopRequested) {
+			impl->m_eventBase->LoopExit();
+		}
+	};
+
+	m_wakeupEvent = std::make_unique<ev::Event>(
+		*m_eventBase, 
+		m_wakeupSockets[0], 
+		EV_READ | EV_PERSIST, 
+		wakeupCallback, 
+		this
+	);
+	m_wakeupEvent->Add();
+}
+
 void EventLoop::Impl::InitSignalsEvents()
 {
 	auto signalCallback = [](evutil_socket_t fd, short event, void *arg) {
@@ -195,24 +294,74 @@ void EventLoop::Impl::InitSignalsEvents()
 	m_sigintSignalEvent->Add();
 }
 
-void EventLoop::Impl::RecvInetCallback()
+void EventLoop::Impl::CleanupTimerCallback()
+{
+	std::unique_lock lock(m_serverList->GetMutex());
+	Clock::Update();
+	m_serverList->UpdateState();
+}
+
+void EventLoop::Impl::SecondTimerCallback()
 {
-	NetAddress senderAddr = m_socketInet->RecvFrom();
-	m_requestHandler->HandlePacket(*m_socketInet, senderAddr);
+	Clock::Update();
+	if (m_stopRequested) 
+	{
+		m_eventBase->LoopExit();
+		return;
+	}
+	m_requestHandler->UpdateState();
+
+	// counters belong to this loop and aren't synchronized, so they're logged from its own timer
+	if (m_statisticsTimer.IntervalElapsed(StatisticsLogInterval)) 
+	{
+		m_statisticsTimer.Reset();
+		LogStatistics();
+	}
 }
 
-void EventLoop::Impl::RecvInet6Callback()
+void EventLoop::Impl::SnapshotTimerCallback()
 {
-	NetAddress senderAddr = m_socketInet6->RecvFrom();
-	m_requestHandler->HandlePacket(*m_socketInet6, senderAddr);
+	// list state is only copied under lock, it's serialized and written by snapshot manager thread
+	ServerListSnapshot snapshot;
+	{
+		std::shared_lock lock(m_serverList->GetMutex());
+		Clock::Update();
+		snapshot = m_serverList->TakeSnapshot();
+	}
+	m_snapshotManager->Save(std::move(snapshot));
 }
 
-void EventLoop::Impl::CleanupTimerCallback()
+void EventLoop::Impl::LogStatistics() const
 {
-	m_serverList->UpdateState();
+	if (m_socketInet) {
+		LogSocketStatistics("IPv4", *m_socketInet);
+	}
+	if (m_socketInet6) {
+		LogSocketStatistics("IPv6", *m_socketInet6);
+	}
+	LogRequestStatistics();
 }
 
-void EventLoop::Impl::SecondTimerCallback()
+void EventLoop::Impl::LogSocketStatistics(const char *name, const Socket &socket) const
 {
-	m_requestHandler->UpdateState();
+	const SocketStatistics &stats = socket.GetStatistics();
+	Utils::Log("{} socket: received {} datagrams ({} calls), {} errors, {} truncated, {} dropped by kernel; sent {} datagrams, {} errors, {} dropped\n",
+		name,
+		stats.receivedDatagrams,
+		stats.recvCalls,
+		stats.recvErrors,
+		stats.truncatedDatagrams,
+		stats.kernelDrops,
+		stats.sentDatagrams,
+		stats.sendErrors,
+		stats.droppedDatagrams);
+}
+
+void EventLoop::Impl::LogRequestStatistics() const
+{
+	const DispatcherStatistics &stats = m_requestHandler->GetStatistics();
+	for (const RequestDescriptor &descriptor : RequestTypes::Descriptors) {
+		Utils::Log("Requests of type \"{}\": {}\n", descriptor.name, stats.dispatched[static_cast<size_t>(descriptor.type)]);
+	}
+	Utils::Log("Requests rejected: {} unknown, {} disabled\n", stats.unknown, stats.disabled);
 }
@@ -14,18 +14,27 @@ GNU General Public License for more details.
 
 #pragma once
 #include "socket.h"
+#include "io_backend.h"
+#include "server_list.h"
 #include "config_manager.h"
+#include "snapshot_manager.h"
 #include <memory>
 
 class EventLoop
 {
 public:
+	// primary loop is responsible for handling signals, cleaning up shared server list and saving its snapshots
 	EventLoop(std::shared_ptr<Socket> socketIPv4, 
 		std::shared_ptr<Socket> socketIPv6, 
-		std::shared_ptr<ConfigManager> configManager);
+		std::shared_ptr<ConfigManager> configManager,
+		std::shared_ptr<ServerList> serverList,
+		std::shared_ptr<SnapshotManager> snapshotManager,
+		IoBackend::Type ioBackendType,
+		bool primary);
 	~EventLoop();
 
 	void Run();
+	void Stop();
 
 	struct Impl;
 	std::unique_ptr<Impl> m_impl;
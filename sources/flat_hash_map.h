@@ -0,0 +1,459 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "cpu_features.h"
+#include <memory>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <stdexcept>
+#include <cstring>
+#include <stddef.h>
+#include <stdint.h>
+#if CPU_SSE2 == 1
+#include <emmintrin.h>
+#endif
+
+namespace FlatHash
+{
+	// every slot has control byte: empty, deleted or 7 low bits of key hash when slot is used.
+	// control bytes are grouped by 16, so whole group is checked with a few instructions
+	constexpr int8_t EmptyControl = -128;
+	constexpr int8_t DeletedControl = -2;
+	constexpr size_t GroupWidth = 16;
+
+	class Group
+	{
+	public:
+		explicit Group(const int8_t *controls) 
+		{
+#if CPU_SSE2 == 1
+			m_controls = _mm_loadu_si128(reinterpret_cast<const __m128i*>(controls));
+#else
+			std::memcpy(m_controls, controls, GroupWidth);
+#endif
+		}
+
+		// bit masks of matching slots within group
+		uint32_t Match(int8_t hash) const
+		{
+#if CPU_SSE2 == 1
+			return _mm_movemask_epi8(_mm_cmpeq_epi8(m_controls, _mm_set1_epi8(hash)));
+#else
+			uint32_t mask = 0;
+			for (size_t i = 0; i < GroupWidth; i++) {
+				mask |= static_cast<uint32_t>(m_controls[i] == hash) << i;
+			}
+			return mask;
+#endif
+		}
+
+		uint32_t MatchEmpty() const
+		{
+			return Match(EmptyControl);
+		}
+
+		uint32_t MatchEmptyOrDeleted() const
+		{
+#if CPU_SSE2 == 1
+			return _mm_movemask_epi8(m_controls); // only empty and deleted slots have sign bit set
+#else
+			uint32_t mask = 0;
+			for (size_t i = 0; i < GroupWidth; i++) {
+				mask |= static_cast<uint32_t>(m_controls[i] < 0) << i;
+			}
+			return mask;
+#endif
+		}
+
+	private:
+#if CPU_SSE2 == 1
+		__m128i m_controls;
+#else
+		int8_t m_controls[GroupWidth];
+#endif
+	};
+
+	inline size_t LowestBit(uint32_t mask)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctz(mask);
+#else
+		size_t index = 0;
+		while ((mask & 1) == 0) 
+		{
+			mask >>= 1;
+			index++;
+		}
+		return index;
+#endif
+	}
+
+	template<class T> struct IdentityKey
+	{
+		const T &operator()(const T &value) const { return value; }
+	};
+
+	template<class T> struct PairFirstKey
+	{
+		const typename T::first_type &operator()(const T &value) const { return value.first; }
+	};
+}
+
+// open addressing hash table, values are stored inline in flat array so there is no allocation
+// per insert. erased slots are marked as deleted, so erasing never moves other values, but any
+// insert could rehash table and invalidate iterators and references to values.
+template<class Key, class Value, class KeyOf, class Hash, class Equal>
+class FlatHashTable
+{
+public:
+	template<bool IsConst> class Iterator
+	{
+	public:
+		using TablePointer = std::conditional_t<IsConst, const FlatHashTable*, FlatHashTable*>;
+		using Reference = std::conditional_t<IsConst, const Value&, Value&>;
+		using Pointer = std::conditional_t<IsConst, const Value*, Value*>;
+
+		Iterator(TablePointer table, size_t index) : m_table(table), m_index(index) { SkipUnused(); }
+		Iterator(const Iterator &other) = default;
+		Iterator &operator=(const Iterator &other) = default;
+		// mutable iterator converts to const one, but not vice versa
+		template<bool OtherConst, class = std::enable_if_t<IsConst && !OtherConst>>
+		Iterator(const Iterator<OtherConst> &other) : m_table(other.m_table), m_index(other.m_index) {}
+
+		Reference operator*() const { return m_table->m_slots[m_index]; }
+		Pointer operator->() const { return &m_table->m_slots[m_index]; }
+		bool operator==(const Iterator &rhs) const { return m_index == rhs.m_index; }
+		bool operator!=(const Iterator &rhs) const { return m_index != rhs.m_index; }
+
+		Iterator &operator++()
+		{
+			m_index++;
+			SkipUnused();
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			Iterator prev = *this;
+			++(*this);
+			return prev;
+		}
+
+	private:
+		friend class FlatHashTable;
+		friend class Iterator<true>;
+
+		void SkipUnused()
+		{
+			while (m_index < m_table->m_capacity && m_table->m_controls[m_index] < 0) {
+				m_index++;
+			}
+		}
+
+		TablePointer m_table;
+		size_t m_index;
+	};
+
+	using iterator = Iterator<false>;
+	using const_iterator = Iterator<true>;
+
+	FlatHashTable() :
+		m_slots(nullptr),
+		m_capacity(0),
+		m_size(0),
+		m_deletedCount(0)
+	{
+	}
+
+	~FlatHashTable()
+	{
+		DestroySlots();
+	}
+
+	FlatHashTable(const FlatHashTable&) = delete;
+	FlatHashTable &operator=(const FlatHashTable&) = delete;
+
+	FlatHashTable(FlatHashTable &&other) noexcept : FlatHashTable()
+	{
+		Swap(other);
+	}
+
+	FlatHashTable &operator=(FlatHashTable &&other) noexcept
+	{
+		Swap(other);
+		return *this;
+	}
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, m_capacity); }
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, m_capacity); }
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	iterator find(const Key &key)
+	{
+		return iterator(this, FindIndex(key));
+	}
+
+	const_iterator find(const Key &key) const
+	{
+		return const_iterator(this, FindIndex(key));
+	}
+
+	size_t count(const Key &key) const
+	{
+		return (FindIndex(key) != m_capacity) ? 1 : 0;
+	}
+
+	std::pair<iterator, bool> insert(const Value &value)
+	{
+		return Emplace(KeyOf{}(value), value);
+	}
+
+	std::pair<iterator, bool> insert(Value &&value)
+	{
+		return Emplace(KeyOf{}(value), std::move(value));
+	}
+
+	iterator erase(const_iterator it)
+	{
+		EraseIndex(it.m_index);
+		return iterator(this, it.m_index + 1);
+	}
+
+	iterator erase(iterator it)
+	{
+		return erase(const_iterator(it));
+	}
+
+	size_t erase(const Key &key)
+	{
+		const size_t index = FindIndex(key);
+		if (index == m_capacity) {
+			return 0;
+		}
+		EraseIndex(index);
+		return 1;
+	}
+
+	void clear()
+	{
+		// capacity is kept, so tables which are cleared periodically don't allocate again
+		for (size_t i = 0; i < m_capacity; i++) 
+		{
+			if (m_controls[i] >= 0) {
+				m_slots[i].~Value();
+			}
+		}
+		if (m_capacity > 0) {
+			std::memset(m_controls.get(), FlatHash::EmptyControl, m_capacity);
+		}
+		m_size = 0;
+		m_deletedCount = 0;
+	}
+
+	void reserve(size_t count)
+	{
+		if (count > MaxLoad(m_capacity)) {
+			Rehash(CapacityFor(count));
+		}
+	}
+
+protected:
+	template<class K, class... Args> std::pair<iterator, bool> Emplace(const K &key, Args&&... args)
+	{
+		const size_t hash = Hash{}(key);
+		const size_t existing = FindIndex(key, hash);
+		if (existing != m_capacity) {
+			return { iterator(this, existing), false };
+		}
+
+		if (m_size + m_deletedCount + 1 > MaxLoad(m_capacity)) 
+		{
+			// table full of deleted slots is just cleaned up, otherwise it grows
+			const size_t capacity = (m_size + 1 > MaxLoad(m_capacity) / 2) ? CapacityFor(m_size + 1) : m_capacity;
+			Rehash(capacity);
+		}
+
+		const size_t index = FindInsertIndex(hash);
+		if (m_controls[index] == FlatHash::DeletedControl) {
+			m_deletedCount--;
+		}
+		new (&m_slots[index]) Value(std::forward<Args>(args)...);
+		m_controls[index] = ControlByte(hash);
+		m_size++;
+		return { iterator(this, index), true };
+	}
+
+private:
+	static size_t GroupIndex(size_t hash) { return hash >> 7; }
+	static int8_t ControlByte(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+	static size_t MaxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+	static size_t CapacityFor(size_t count)
+	{
+		size_t capacity = FlatHash::GroupWidth;
+		while (MaxLoad(capacity) < count) {
+			capacity *= 2;
+		}
+		return capacity;
+	}
+
+	size_t FindIndex(const Key &key) const
+	{
+		if (m_size == 0) {
+			return m_capacity;
+		}
+		return FindIndex(key, Hash{}(key));
+	}
+
+	size_t FindIndex(const Key &key, size_t hash) const
+	{
+		if (m_capacity == 0) {
+			return m_capacity;
+		}
+
+		// groups are probed in triangular sequence, it visits every group when groups count is power of two
+		const size_t groupsMask = m_capacity / FlatHash::GroupWidth - 1;
+		size_t group = GroupIndex(hash) & groupsMask;
+		for (size_t step = 1; step <= groupsMask + 1; step++)
+		{
+			const int8_t *controls = &m_controls[group * FlatHash::GroupWidth];
+			FlatHash::Group groupData(controls);
+			for (uint32_t mask = groupData.Match(ControlByte(hash)); mask != 0; mask &= mask - 1)
+			{
+				const size_t index = group * FlatHash::GroupWidth + FlatHash::LowestBit(mask);
+				if (Equal{}(KeyOf{}(m_slots[index]), key)) {
+					return index;
+				}
+			}
+			if (groupData.MatchEmpty() != 0) {
+				break; // key would be placed in this group if it was inserted
+			}
+			group = (group + step) & groupsMask;
+		}
+		return m_capacity;
+	}
+
+	size_t FindInsertIndex(size_t hash) const
+	{
+		const size_t groupsMask = m_capacity / FlatHash::GroupWidth - 1;
+		size_t group = GroupIndex(hash) & groupsMask;
+		for (size_t step = 1; ; step++)
+		{
+			FlatHash::Group groupData(&m_controls[group * FlatHash::GroupWidth]);
+			const uint32_t mask = groupData.MatchEmptyOrDeleted();
+			if (mask != 0) {
+				return group * FlatHash::GroupWidth + FlatHash::LowestBit(mask);
+			}
+			group = (group + step) & groupsMask;
+		}
+	}
+
+	void EraseIndex(size_t index)
+	{
+		m_slots[index].~Value();
+		m_controls[index] = FlatHash::DeletedControl;
+		m_size--;
+		m_deletedCount++;
+	}
+
+	void Rehash(size_t capacity)
+	{
+		std::unique_ptr<int8_t[]> oldControls = std::move(m_controls);
+		Value *oldSlots = m_slots;
+		const size_t oldCapacity = m_capacity;
+
+		m_controls = std::make_unique<int8_t[]>(capacity);
+		std::memset(m_controls.get(), FlatHash::EmptyControl, capacity);
+		m_slots = std::allocator<Value>().allocate(capacity);
+		m_capacity = capacity;
+		m_deletedCount = 0;
+
+		for (size_t i = 0; i < oldCapacity; i++)
+		{
+			if (oldControls[i] >= 0)
+			{
+				const size_t hash = Hash{}(KeyOf{}(oldSlots[i]));
+				const size_t index = FindInsertIndex(hash);
+				new (&m_slots[index]) Value(std::move(oldSlots[i]));
+				m_controls[index] = ControlByte(hash);
+				oldSlots[i].~Value();
+			}
+		}
+		if (oldSlots) {
+			std::allocator<Value>().deallocate(oldSlots, oldCapacity);
+		}
+	}
+
+	void DestroySlots()
+	{
+		clear();
+		if (m_slots) {
+			std::allocator<Value>().deallocate(m_slots, m_capacity);
+		}
+	}
+
+	void Swap(FlatHashTable &other) noexcept
+	{
+		std::swap(m_controls, other.m_controls);
+		std::swap(m_slots, other.m_slots);
+		std::swap(m_capacity, other.m_capacity);
+		std::swap(m_size, other.m_size);
+		std::swap(m_deletedCount, other.m_deletedCount);
+	}
+
+	std::unique_ptr<int8_t[]> m_controls;
+	Value *m_slots;
+	size_t m_capacity;
+	size_t m_size;
+	size_t m_deletedCount;
+};
+
+// keys of stored pairs must not be modified through iterators
+template<class Key, class T, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>>
+class FlatHashMap : public FlatHashTable<Key, std::pair<Key, T>, FlatHash::PairFirstKey<std::pair<Key, T>>, Hash, Equal>
+{
+public:
+	T &operator[](const Key &key)
+	{
+		return this->Emplace(key, key, T()).first->second;
+	}
+
+	T &at(const Key &key)
+	{
+		auto it = this->find(key);
+		if (it == this->end()) {
+			throw std::out_of_range("key not found in flat hash map");
+		}
+		return it->second;
+	}
+
+	const T &at(const Key &key) const
+	{
+		auto it = this->find(key);
+		if (it == this->end()) {
+			throw std::out_of_range("key not found in flat hash map");
+		}
+		return it->second;
+	}
+};
+
+template<class Key, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>>
+class FlatHashSet : public FlatHashTable<Key, Key, FlatHash::IdentityKey<Key>, Hash, Equal>
+{
+};
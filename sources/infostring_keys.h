@@ -0,0 +1,132 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include <string_view>
+#include <optional>
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+// all keys which are used by master server, other keys in infostrings are ignored
+enum class InfostringKey : uint8_t
+{
+	Challenge,
+	Protocol,
+	Players,
+	Max,
+	Bots,
+	Region,
+	Gamedir,
+	Map,
+	Version,
+	Os,
+	Product,
+	Type,
+	Password,
+	Secure,
+	Lan,
+	Nat,
+	Key,
+	Clver,
+	Page,
+	NoEmpty,
+	NoFull,
+	NoPassword,
+	Dedicated,
+	Count
+};
+
+namespace InfostringKeys
+{
+	constexpr size_t Count = static_cast<size_t>(InfostringKey::Count);
+	constexpr std::array<std::string_view, Count> Names = {
+		"challenge", "protocol", "players", "max", "bots", "region", "gamedir", "map", 
+		"version", "os", "product", "type", "password", "secure", "lan", "nat", 
+		"key", "clver", "page", "noempty", "nofull", "nopassword", "dedicated"
+	};
+
+	static_assert(Count <= 32, "keys set should fit into 32-bit mask");
+
+	template<class... Keys> constexpr uint32_t Mask(Keys... keys)
+	{
+		return ((1u << static_cast<uint32_t>(keys)) | ... | 0u);
+	}
+
+	// perfect hash: seed is picked at compile time, so every known key gets own slot of table,
+	// and lookup is one hash calculation, one table load and one string comparison
+	constexpr size_t TableSize = 64;
+
+	constexpr uint32_t Hash(std::string_view text, uint32_t seed)
+	{
+		uint32_t hash = 2166136261u ^ seed;
+		for (char character : text) 
+		{
+			hash ^= static_cast<uint8_t>(character);
+			hash *= 16777619u;
+		}
+		return hash ^ (hash >> 15);
+	}
+
+	constexpr bool SeedIsPerfect(uint32_t seed)
+	{
+		bool used[TableSize] = {};
+		for (std::string_view name : Names) 
+		{
+			const size_t slot = Hash(name, seed) % TableSize;
+			if (used[slot]) {
+				return false;
+			}
+			used[slot] = true;
+		}
+		return true;
+	}
+
+	constexpr uint32_t FindSeed()
+	{
+		for (uint32_t seed = 0; seed < 100000; seed++) 
+		{
+			if (SeedIsPerfect(seed)) {
+				return seed;
+			}
+		}
+		return UINT32_MAX;
+	}
+
+	constexpr uint32_t Seed = FindSeed();
+	static_assert(Seed != UINT32_MAX, "failed to find perfect hash seed for infostring keys");
+
+	constexpr std::array<uint8_t, TableSize> BuildTable()
+	{
+		std::array<uint8_t, TableSize> table = {};
+		for (size_t i = 0; i < TableSize; i++) {
+			table[i] = UINT8_MAX;
+		}
+		for (size_t i = 0; i < Count; i++) {
+			table[Hash(Names[i], Seed) % TableSize] = static_cast<uint8_t>(i);
+		}
+		return table;
+	}
+
+	constexpr std::array<uint8_t, TableSize> Table = BuildTable();
+
+	constexpr std::optional<InfostringKey> Find(std::string_view name)
+	{
+		const uint8_t index = Table[Hash(name, Seed) % TableSize];
+		if (index != UINT8_MAX && Names[index] == name) {
+			return static_cast<InfostringKey>(index);
+		}
+		return std::nullopt;
+	}
+}
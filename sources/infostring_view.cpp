@@ -0,0 +1,61 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "infostring_view.h"
+#include "byte_scan.h"
+#include <algorithm>
+
+InfostringView::InfostringView(std::string_view data)
+{
+	Parse(data);
+}
+
+void InfostringView::Parse(std::string_view data)
+{
+	m_presentKeys = 0;
+	if (!data.empty() && data[0] == '\\') {
+		data.remove_prefix(1);
+	}
+
+	// pairs are separated same way as keys from values, so it's just every two tokens
+	while (!data.empty())
+	{
+		const size_t keyEnd = ByteScan::FindByte(data.data(), data.size(), '\\');
+		if (keyEnd == data.size()) {
+			break; // key without value is ignored
+		}
+		
+		std::string_view key = data.substr(0, keyEnd);
+		data.remove_prefix(keyEnd + 1);
+		const size_t valueEnd = ByteScan::FindByte(data.data(), data.size(), '\\');
+		std::string_view value = data.substr(0, valueEnd);
+		data.remove_prefix(std::min(valueEnd + 1, data.size()));
+
+		// for duplicated keys last one is used
+		auto knownKey = InfostringKeys::Find(key);
+		if (knownKey.has_value()) 
+		{
+			m_values[static_cast<size_t>(knownKey.value())] = value;
+			m_presentKeys |= InfostringKeys::Mask(knownKey.value());
+		}
+	}
+}
+
+std::optional<std::string_view> InfostringView::operator[](InfostringKey key) const
+{
+	if (m_presentKeys & InfostringKeys::Mask(key)) {
+		return m_values[static_cast<size_t>(key)];
+	}
+	return std::nullopt;
+}
@@ -0,0 +1,38 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "infostring_keys.h"
+#include <string_view>
+#include <optional>
+#include <array>
+#include <stdint.h>
+
+// parses infostring in place, values are just slices of source text, so source should outlive 
+// this object. it's meant for requests, which are handled right from receive buffer. 
+// only known keys are kept, each one in own slot, so lookup is just array access
+class InfostringView
+{
+public:
+	InfostringView() = default;
+	InfostringView(std::string_view data);
+
+	void Parse(std::string_view data);
+	bool Contains(uint32_t keysMask) const { return (m_presentKeys & keysMask) == keysMask; }
+	std::optional<std::string_view> operator[](InfostringKey key) const;
+
+private:
+	std::array<std::string_view, InfostringKeys::Count> m_values;
+	uint32_t m_presentKeys = 0;
+};
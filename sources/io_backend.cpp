@@ -0,0 +1,63 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "io_backend.h"
+#include "libevent_io_backend.h"
+#include "utils.h"
+#if ENABLE_IO_URING == 1
+#include "uring_io_backend.h"
+#endif
+
+std::unique_ptr<IoBackend> IoBackend::Create(Type type,
+	ev::EventBase &eventBase,
+	RequestHandler &requestHandler,
+	const ConfigData &configData,
+	const std::vector<std::shared_ptr<Socket>> &sockets)
+{
+	if (type == Type::IoUring)
+	{
+#if ENABLE_IO_URING == 1
+		try {
+			return std::make_unique<UringIoBackend>(eventBase, requestHandler, configData, sockets);
+		}
+		catch (const std::exception &ex) {
+			Utils::Log("Failed to initialize io_uring backend: {}, falling back to libevent\n", ex.what());
+		}
+#else
+		Utils::Log("io_uring backend is not available in this build, falling back to libevent\n");
+#endif
+	}
+	return std::make_unique<LibeventIoBackend>(eventBase, requestHandler, configData, sockets);
+}
+
+std::optional<IoBackend::Type> IoBackend::ParseType(std::string_view name)
+{
+	if (name.compare(GetTypeName(Type::Libevent)) == 0) {
+		return Type::Libevent;
+	}
+	else if (name.compare(GetTypeName(Type::IoUring)) == 0) {
+		return Type::IoUring;
+	}
+	return std::nullopt;
+}
+
+const char *IoBackend::GetTypeName(Type type)
+{
+	switch (type)
+	{
+		case Type::Libevent: return "libevent";
+		case Type::IoUring: return "io_uring";
+	}
+	return "unknown";
+}
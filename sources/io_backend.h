@@ -0,0 +1,46 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "socket.h"
+#include "config_data.h"
+#include "request_handler.h"
+#include "libevent_wrappers.h"
+#include <memory>
+#include <vector>
+#include <optional>
+#include <string_view>
+
+// delivers datagrams from sockets to request handler, every backend is driven by libevent loop
+class IoBackend
+{
+public:
+	enum class Type
+	{
+		Libevent,
+		IoUring
+	};
+
+	virtual ~IoBackend() = default;
+	virtual Type GetType() const = 0;
+
+	static std::unique_ptr<IoBackend> Create(Type type,
+		ev::EventBase &eventBase,
+		RequestHandler &requestHandler,
+		const ConfigData &configData,
+		const std::vector<std::shared_ptr<Socket>> &sockets);
+
+	static std::optional<Type> ParseType(std::string_view name);
+	static const char *GetTypeName(Type type);
+};
@@ -0,0 +1,68 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "libevent_io_backend.h"
+#include "clock.h"
+#include <algorithm>
+
+LibeventIoBackend::LibeventIoBackend(ev::EventBase &eventBase,
+	RequestHandler &requestHandler,
+	const ConfigData &configData,
+	const std::vector<std::shared_ptr<Socket>> &sockets) :
+	m_requestHandler(requestHandler),
+	m_configData(configData)
+{
+	auto recvCallback = [](evutil_socket_t fd, short event, void *arg) {
+		SocketContext *context = reinterpret_cast<SocketContext*>(arg);
+		context->backend->ReceivePackets(*context->socket);
+	};
+
+	for (const auto &socket : sockets)
+	{
+		auto context = std::make_unique<SocketContext>();
+		context->backend = this;
+		context->socket = socket;
+		context->event = std::make_unique<ev::Event>(
+			eventBase,
+			socket->GetDescriptor(),
+			EV_READ | EV_PERSIST,
+			recvCallback,
+			context.get()
+		);
+		context->event->Add();
+		m_contexts.push_back(std::move(context));
+	}
+}
+
+void LibeventIoBackend::ReceivePackets(Socket &socket)
+{
+	// drain socket until it would block, but limit amount of datagrams handled per wakeup,
+	// so one socket can't starve timers and other socket. Leftovers will trigger event again.
+	size_t budget = m_configData.GetRecvBudget();
+	Clock::Update(); // whole wakeup is handled with single clock sample
+	while (budget > 0)
+	{
+		const size_t requested = std::min(budget, socket.GetRecvBatchSize());
+		const size_t received = socket.RecvBatch(requested);
+		for (size_t i = 0; i < received; i++) {
+			m_requestHandler.HandlePacket(socket, socket.GetDatagram(i));
+		}
+		socket.FlushSendQueue(); // send all replies produced by this batch at once
+
+		if (received == 0) {
+			break; // socket queue is drained
+		}
+		budget -= received;
+	}
+}
@@ -0,0 +1,43 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "io_backend.h"
+#include <memory>
+#include <vector>
+
+class LibeventIoBackend : public IoBackend
+{
+public:
+	LibeventIoBackend(ev::EventBase &eventBase,
+		RequestHandler &requestHandler,
+		const ConfigData &configData,
+		const std::vector<std::shared_ptr<Socket>> &sockets);
+
+	Type GetType() const override { return Type::Libevent; }
+
+private:
+	struct SocketContext
+	{
+		LibeventIoBackend *backend;
+		std::shared_ptr<Socket> socket;
+		std::unique_ptr<ev::Event> event;
+	};
+
+	void ReceivePackets(Socket &socket);
+
+	RequestHandler &m_requestHandler;
+	const ConfigData &m_configData;
+	std::vector<std::unique_ptr<SocketContext>> m_contexts;
+};
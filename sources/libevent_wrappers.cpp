@@ -55,3 +55,8 @@ void ev::Event::Add(const timeval *timeout)
 {
 	event_add(m_address, timeout);
 }
+
+void ev::Event::Activate(int result)
+{
+	event_active(m_address, result, 0);
+}
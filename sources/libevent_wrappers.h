@@ -39,6 +39,7 @@ namespace ev
 		Event(EventBase &base, evutil_socket_t fd, short events, event_callback_fn callback, void *callback_arg);
 		~Event();
 		void Add(const timeval *timeout = nullptr);
+		void Activate(int result);
 	private:
 		event *m_address;
 	};
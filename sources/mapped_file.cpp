@@ -0,0 +1,120 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "mapped_file.h"
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <fmt/core.h>
+
+#if BUILD_WIN32 == 1
+#include <windows.h>
+#elif BUILD_POSIX == 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if BUILD_WIN32 == 1
+MappedFile::MappedFile(const std::filesystem::path &path) :
+	m_data(nullptr),
+	m_size(0),
+	m_fileHandle(INVALID_HANDLE_VALUE),
+	m_mappingHandle(nullptr)
+{
+	m_fileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_fileHandle == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error(fmt::format("failed to open file: error {}", GetLastError()));
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_fileHandle, &fileSize)) 
+	{
+		CloseHandle(m_fileHandle);
+		throw std::runtime_error(fmt::format("failed to get file size: error {}", GetLastError()));
+	}
+
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+	if (m_size == 0) {
+		return; // empty files can't be mapped
+	}
+
+	m_mappingHandle = CreateFileMappingW(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mappingHandle) {
+		m_data = reinterpret_cast<const uint8_t*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (!m_data)
+	{
+		const DWORD error = GetLastError();
+		if (m_mappingHandle) {
+			CloseHandle(m_mappingHandle);
+		}
+		CloseHandle(m_fileHandle);
+		throw std::runtime_error(fmt::format("failed to map file: error {}", error));
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_data) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mappingHandle) {
+		CloseHandle(m_mappingHandle);
+	}
+	CloseHandle(m_fileHandle);
+}
+#elif BUILD_POSIX == 1
+MappedFile::MappedFile(const std::filesystem::path &path) :
+	m_data(nullptr),
+	m_size(0)
+{
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error(fmt::format("failed to open file: {}", std::strerror(errno)));
+	}
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) < 0) 
+	{
+		const int error = errno;
+		close(fd);
+		throw std::runtime_error(fmt::format("failed to get file size: {}", std::strerror(error)));
+	}
+
+	m_size = static_cast<size_t>(fileStat.st_size);
+	if (m_size == 0) 
+	{
+		close(fd);
+		return; // empty files can't be mapped
+	}
+
+	// mapping stays valid after descriptor is closed
+	void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	const int error = errno;
+	close(fd);
+	if (data == MAP_FAILED) {
+		throw std::runtime_error(fmt::format("failed to map file: {}", std::strerror(error)));
+	}
+	m_data = reinterpret_cast<const uint8_t*>(data);
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_data) {
+		munmap(const_cast<uint8_t*>(m_data), m_size);
+	}
+}
+#endif
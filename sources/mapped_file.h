@@ -0,0 +1,40 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "build.h"
+#include <filesystem>
+#include <stdint.h>
+#include <stddef.h>
+
+// read-only memory mapping of whole file, throws when file couldn't be mapped
+class MappedFile
+{
+public:
+	MappedFile(const std::filesystem::path &path);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile &operator=(const MappedFile&) = delete;
+
+	const uint8_t *GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	const uint8_t *m_data;
+	size_t m_size;
+#if BUILD_WIN32 == 1
+	void *m_fileHandle;
+	void *m_mappingHandle;
+#endif
+};
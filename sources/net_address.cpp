@@ -17,35 +17,30 @@ GNU General Public License for more details.
 #include <event2/util.h>
 #include <stdint.h>
 #include <stdexcept>
+#include <cstring>
 
-NetAddress::NetAddress(AddressFamily family) :
-	m_port(0),
-	m_family(family)
+NetAddress::NetAddress(AddressFamily family)
 {
-	m_addressData.fill(0x0);
+	std::memset(&m_sockaddr, 0, sizeof(m_sockaddr));
+	m_sockaddr.generic.sa_family = (family == AddressFamily::IPv4) ? AF_INET : AF_INET6;
 }
 
 bool NetAddress::FromString(const char *address, uint16_t port)
 {
-	in_addr addr_v4;
-	in6_addr addr_v6;
-
-	if (m_family == AddressFamily::IPv4) 
+	if (GetAddressFamily() == AddressFamily::IPv4) 
 	{
-		if (!evutil_inet_pton(AF_INET, address, &addr_v4)) {
+		if (!evutil_inet_pton(AF_INET, address, &m_sockaddr.v4.sin_addr)) {
 			return false;
 		}
-		std::memcpy(m_addressData.data(), &addr_v4, 4);
+		m_sockaddr.v4.sin_port = htons(port);
 	}
 	else 
 	{
-		if (!evutil_inet_pton(AF_INET6, address, &addr_v6)) {
+		if (!evutil_inet_pton(AF_INET6, address, &m_sockaddr.v6.sin6_addr)) {
 			return false;
 		}
-		std::memcpy(m_addressData.data(), &addr_v6, 16);
+		m_sockaddr.v6.sin6_port = htons(port);
 	}
-
-	m_port = port;
 	return true;
 }
 
@@ -54,16 +49,34 @@ bool NetAddress::operator==(const NetAddress &rhs) const
 	return Equals(rhs, true);
 }
 
+uint16_t NetAddress::GetPort() const
+{
+	return ntohs(GetAddressFamily() == AddressFamily::IPv4 ? m_sockaddr.v4.sin_port : m_sockaddr.v6.sin6_port);
+}
+
+NetAddress::AddressFamily NetAddress::GetAddressFamily() const
+{
+	return (m_sockaddr.generic.sa_family == AF_INET6) ? AddressFamily::IPv6 : AddressFamily::IPv4;
+}
+
 std::pair<const uint8_t*, size_t> NetAddress::GetAddressSpan() const
 {
-	return std::pair<const uint8_t*, size_t>(m_addressData.data(), m_family == AddressFamily::IPv6 ? 16 : 4);
+	if (GetAddressFamily() == AddressFamily::IPv4) {
+		return std::pair<const uint8_t*, size_t>(reinterpret_cast<const uint8_t*>(&m_sockaddr.v4.sin_addr), 4);
+	}
+	return std::pair<const uint8_t*, size_t>(reinterpret_cast<const uint8_t*>(&m_sockaddr.v6.sin6_addr), 16);
+}
+
+socklen_t NetAddress::GetSockaddrLength() const
+{
+	return (GetAddressFamily() == AddressFamily::IPv4) ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
 }
 
 std::string NetAddress::ToString() const
 {
 	char buffer[INET6_ADDRSTRLEN];
-	const int32_t addrFamily = (m_family == AddressFamily::IPv4) ? AF_INET : AF_INET6;
-	if (evutil_inet_ntop(addrFamily, m_addressData.data(), buffer, sizeof(buffer))) {
+	const int32_t addrFamily = m_sockaddr.generic.sa_family;
+	if (evutil_inet_ntop(addrFamily, GetAddressSpan().first, buffer, sizeof(buffer))) {
 		return std::string(buffer);
 	}
 	return std::string("unknown");
@@ -71,13 +84,13 @@ std::string NetAddress::ToString() const
 
 bool NetAddress::Equals(const NetAddress &lhs, bool includePort) const
 {
-	if (m_family != lhs.m_family)
+	if (m_sockaddr.generic.sa_family != lhs.m_sockaddr.generic.sa_family)
 		return false;
-	if (includePort && m_port != lhs.m_port)
+	if (includePort && GetPort() != lhs.GetPort())
 		return false;
 
-	size_t addressLength = (m_family == AddressFamily::IPv6) ? 16 : 4;
-	if (std::memcmp(m_addressData.data(), lhs.m_addressData.data(), addressLength) == 0) {
+	auto [addressData, addressLength] = GetAddressSpan();
+	if (std::memcmp(addressData, lhs.GetAddressSpan().first, addressLength) == 0) {
 		return true;
 	}
 	return false;
@@ -85,11 +98,8 @@ bool NetAddress::Equals(const NetAddress &lhs, bool includePort) const
 
 void NetAddress::ToSockadr(sockaddr_in *address) const
 {
-	if (m_family == AddressFamily::IPv4) 
-	{
-		address->sin_family = AF_INET;
-		address->sin_port = htons(m_port);
-		std::memcpy(&address->sin_addr.s_addr, m_addressData.data(), 4);
+	if (GetAddressFamily() == AddressFamily::IPv4) {
+		std::memcpy(address, &m_sockaddr.v4, sizeof(m_sockaddr.v4));
 	}
 	else {
 		throw std::runtime_error("sockaddr address family mismatching");
@@ -98,11 +108,8 @@ void NetAddress::ToSockadr(sockaddr_in *address) const
 
 void NetAddress::ToSockadr(sockaddr_in6 *address) const
 {
-	if (m_family == AddressFamily::IPv6) 
-	{
-		address->sin6_family = AF_INET6;
-		address->sin6_port = htons(m_port);
-		std::memcpy(&address->sin6_addr, m_addressData.data(), 16);
+	if (GetAddressFamily() == AddressFamily::IPv6) {
+		std::memcpy(address, &m_sockaddr.v6, sizeof(m_sockaddr.v6));
 	}
 	else {
 		throw std::runtime_error("sockaddr address family mismatching");
@@ -111,11 +118,8 @@ void NetAddress::ToSockadr(sockaddr_in6 *address) const
 
 void NetAddress::FromSockadr(const sockaddr_in *address)
 {
-	if (m_family == AddressFamily::IPv4) 
-	{
-		const sockaddr_in *address_v4 = reinterpret_cast<const sockaddr_in*>(address);
-		std::memcpy(m_addressData.data(), &address_v4->sin_addr.s_addr, 4);
-		m_port = ntohs(address_v4->sin_port);
+	if (GetAddressFamily() == AddressFamily::IPv4) {
+		std::memcpy(&m_sockaddr.v4, address, sizeof(m_sockaddr.v4));
 	}
 	else {
 		throw std::runtime_error("sockaddr address family mismatching");
@@ -124,11 +128,8 @@ void NetAddress::FromSockadr(const sockaddr_in *address)
 
 void NetAddress::FromSockadr(const sockaddr_in6 *address)
 {
-	if (m_family == AddressFamily::IPv6) 
-	{
-		const sockaddr_in6 *address_v6 = reinterpret_cast<const sockaddr_in6*>(address);
-		std::memcpy(m_addressData.data(), &address_v6->sin6_addr, 16);
-		m_port = ntohs(address_v6->sin6_port);
+	if (GetAddressFamily() == AddressFamily::IPv6) {
+		std::memcpy(&m_sockaddr.v6, address, sizeof(m_sockaddr.v6));
 	}
 	else {
 		throw std::runtime_error("sockaddr address family mismatching");
@@ -137,20 +138,13 @@ void NetAddress::FromSockadr(const sockaddr_in6 *address)
 
 std::optional<NetAddress> NetAddress::Parse(std::string_view address, uint16_t port)
 {
-	in_addr addr_v4;
-	in6_addr addr_v6;
-	if (evutil_inet_pton(AF_INET, address.data(), &addr_v4))
-	{
-		NetAddress result(AddressFamily::IPv4);
-		std::memcpy(result.m_addressData.data(), &addr_v4, 4);
-		result.m_port = port;
+	NetAddress result(AddressFamily::IPv4);
+	if (result.FromString(address.data(), port)) {
 		return result;
 	}
-	else if (evutil_inet_pton(AF_INET6, address.data(), &addr_v6)) 
-	{
-		NetAddress result(AddressFamily::IPv6);
-		std::memcpy(result.m_addressData.data(), &addr_v6, 16);
-		result.m_port = port;
+
+	result = NetAddress(AddressFamily::IPv6);
+	if (result.FromString(address.data(), port)) {
 		return result;
 	}
 	return std::nullopt;
@@ -17,9 +17,9 @@ GNU General Public License for more details.
 #include <stdint.h>
 #include <string>
 #include <string_view>
-#include <array>
 #include <optional>
 #include <utility>
+#include <cstring>
 
 #if BUILD_WIN32 == 1
 #include <winsock2.h>
@@ -33,8 +33,6 @@ GNU General Public License for more details.
 class NetAddress
 {
 public:
-	friend class NetAddressHash;
-	friend class NetAddressPortHash;
 	enum class AddressFamily
 	{
 		IPv4,
@@ -49,9 +47,12 @@ public:
 	NetAddress &operator=(NetAddress&&) noexcept = default;
 	bool operator==(const NetAddress &rhs) const;
 
-	uint16_t GetPort() const { return m_port; }
-	AddressFamily GetAddressFamily() const { return m_family; }
+	uint16_t GetPort() const;
+	AddressFamily GetAddressFamily() const;
 	std::pair<const uint8_t*, size_t> GetAddressSpan() const;
+	const sockaddr *GetSockaddr() const { return &m_sockaddr.generic; }
+	sockaddr *GetSockaddr() { return &m_sockaddr.generic; }
+	socklen_t GetSockaddrLength() const;
 	std::string ToString() const;
 
 	bool FromString(const char *address, uint16_t port);
@@ -63,30 +64,66 @@ public:
 
 	static std::optional<NetAddress> Parse(std::string_view address, uint16_t port = 0);
 
+	static constexpr socklen_t MaxSockaddrLength = sizeof(sockaddr_in6);
+
 private:
-	uint16_t m_port;
-	AddressFamily m_family;
-	std::array<uint8_t, 16> m_addressData;
+	// address is kept right in kernel format, so it could be passed to socket calls as is
+	union SockaddrData
+	{
+		sockaddr generic;
+		sockaddr_in v4;
+		sockaddr_in6 v6;
+	};
+
+	SockaddrData m_sockaddr;
+};
+
+// addresses are hashed as one or two integers instead of byte strings. all bits of result 
+// are well mixed, since flat hash tables are using both low and high bits of it
+class NetAddressHashBase
+{
+protected:
+	static uint64_t Mix(uint64_t value)
+	{
+		value ^= value >> 33;
+		value *= 0xff51afd7ed558ccdULL;
+		value ^= value >> 33;
+		value *= 0xc4ceb9fe1a85ec53ULL;
+		value ^= value >> 33;
+		return value;
+	}
+
+	static std::size_t Calculate(const NetAddress &address, uint64_t port)
+	{
+		auto [addrData, addrSize] = address.GetAddressSpan();
+		if (addrSize == 4) 
+		{
+			uint32_t value;
+			std::memcpy(&value, addrData, sizeof(value));
+			return static_cast<std::size_t>(Mix(value | (port << 32)));
+		}
+
+		uint64_t high, low;
+		std::memcpy(&high, addrData, sizeof(high));
+		std::memcpy(&low, addrData + sizeof(high), sizeof(low));
+		return static_cast<std::size_t>(Mix(high ^ Mix(low ^ port)));
+	}
 };
 
-class NetAddressHash
+class NetAddressHash : public NetAddressHashBase
 {
 public:
 	std::size_t operator()(const NetAddress &address) const noexcept
 	{
-		std::size_t addrSize = address.GetAddressSpan().second;
-		return std::hash<std::string_view>{}({ reinterpret_cast<const char*>(address.m_addressData.data()), addrSize });
+		return Calculate(address, 0);
 	}
 };
 
-class NetAddressPortHash
+class NetAddressPortHash : public NetAddressHashBase
 {
 public:
 	std::size_t operator()(const NetAddress &address) const noexcept
 	{
-		std::size_t addrSize = address.GetAddressSpan().second;
-		std::size_t addrHash = std::hash<std::string_view>{}({ reinterpret_cast<const char*>(address.m_addressData.data()), addrSize });
-		std::size_t portHash = std::hash<uint16_t>{}(address.m_port);
-		return addrHash ^ (portHash << 1);
+		return Calculate(address, address.GetPort());
 	}
 };
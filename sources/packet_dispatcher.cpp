@@ -0,0 +1,100 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "packet_dispatcher.h"
+#include <algorithm>
+#include <cstring>
+
+PacketDispatcher::PacketDispatcher()
+{
+	m_enabled.fill(true);
+}
+
+void PacketDispatcher::Register(RequestType type, Handler handler)
+{
+	m_handlers[static_cast<size_t>(type)] = std::move(handler);
+	RebuildTable();
+}
+
+void PacketDispatcher::SetEnabled(RequestType type, bool enabled)
+{
+	m_enabled[static_cast<size_t>(type)] = enabled;
+}
+
+bool PacketDispatcher::Dispatch(Socket &socket, const Datagram &datagram)
+{
+	if (datagram.size == 0) 
+	{
+		m_statistics.unknown++;
+		return false;
+	}
+
+	const Bucket &bucket = m_buckets[datagram.data[0]];
+	for (size_t i = bucket.first; i < bucket.first + bucket.count; i++)
+	{
+		// first byte is already matched by bucket, and longer headers go first
+		const Route &route = m_routes[i];
+		if (datagram.size < route.header.size()) {
+			continue;
+		}
+		if (std::memcmp(datagram.data + 1, route.header.data() + 1, route.header.size() - 1) != 0) {
+			continue;
+		}
+
+		const size_t index = static_cast<size_t>(route.type);
+		if (!m_enabled[index]) 
+		{
+			m_statistics.disabled++;
+			return false;
+		}
+		m_statistics.dispatched[index]++;
+		m_handlers[index](socket, datagram);
+		return true;
+	}
+
+	m_statistics.unknown++;
+	return false;
+}
+
+void PacketDispatcher::RebuildTable()
+{
+	m_routes.clear();
+	for (const RequestDescriptor &descriptor : RequestTypes::Descriptors)
+	{
+		if (m_handlers[static_cast<size_t>(descriptor.type)]) {
+			m_routes.push_back({ descriptor.header, descriptor.type });
+		}
+	}
+
+	// requests with same first byte should be adjacent, and longer header has priority
+	// over shorter one that is prefix of it (like "adminchallenge" and "admin")
+	std::stable_sort(m_routes.begin(), m_routes.end(), [](const Route &a, const Route &b) {
+		const uint8_t firstA = static_cast<uint8_t>(a.header[0]);
+		const uint8_t firstB = static_cast<uint8_t>(b.header[0]);
+		if (firstA != firstB) {
+			return firstA < firstB;
+		}
+		return a.header.size() > b.header.size();
+	});
+
+	m_buckets.fill(Bucket());
+	for (size_t i = 0; i < m_routes.size(); i++)
+	{
+		Bucket &bucket = m_buckets[static_cast<uint8_t>(m_routes[i].header[0])];
+		if (bucket.count == 0) {
+			bucket.first = static_cast<uint8_t>(i);
+		}
+		bucket.count++;
+	}
+}
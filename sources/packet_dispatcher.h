@@ -0,0 +1,64 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "request_types.h"
+#include "socket.h"
+#include <array>
+#include <vector>
+#include <functional>
+#include <stdint.h>
+
+struct DispatcherStatistics
+{
+	std::array<uint64_t, RequestTypes::Count> dispatched = {};
+	uint64_t unknown = 0; // doesn't match any registered header
+	uint64_t disabled = 0; // matched header of request type that is turned off
+};
+
+// routes datagrams to handlers by their header, candidates are looked up by first byte
+// in a table, so unknown packets are rejected right away and more request types 
+// don't make classification of other ones slower
+class PacketDispatcher
+{
+public:
+	using Handler = std::function<void(Socket &socket, const Datagram &datagram)>;
+
+	PacketDispatcher();
+	void Register(RequestType type, Handler handler);
+	void SetEnabled(RequestType type, bool enabled);
+	bool Dispatch(Socket &socket, const Datagram &datagram);
+	const DispatcherStatistics &GetStatistics() const { return m_statistics; }
+
+private:
+	struct Route
+	{
+		std::string_view header;
+		RequestType type;
+	};
+
+	struct Bucket
+	{
+		uint8_t first = 0;
+		uint8_t count = 0;
+	};
+
+	void RebuildTable();
+
+	std::array<Bucket, 256> m_buckets;
+	std::vector<Route> m_routes;
+	std::array<Handler, RequestTypes::Count> m_handlers;
+	std::array<bool, RequestTypes::Count> m_enabled;
+	DispatcherStatistics m_statistics;
+};
@@ -0,0 +1,122 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "packet_filter.h"
+#include "request_types.h"
+#include <algorithm>
+#include <stdexcept>
+
+#if BUILD_LINUX == 1
+// socket filters of UDP sockets are running on packet with UDP header at start,
+// and packet length accounts it too
+static constexpr uint32_t UdpHeaderSize = 8;
+static constexpr uint32_t AcceptPacket = 0xFFFFFFFF;
+static constexpr uint32_t DropPacket = 0;
+#endif
+
+PacketFilter::PacketFilter(size_t minLength, size_t maxLength) :
+	m_minLength(minLength),
+	m_maxLength(maxLength)
+{
+}
+
+void PacketFilter::AddHeader(std::string_view header)
+{
+	m_headers.push_back(header);
+}
+
+PacketFilter PacketFilter::CreateForRequests()
+{
+	// same descriptors that are used by packet dispatcher, so filter can't get out of sync with it
+	PacketFilter filter(2, Socket::MaxDatagramSize);
+	for (const RequestDescriptor &descriptor : RequestTypes::Descriptors) {
+		filter.AddHeader(descriptor.header);
+	}
+	return filter;
+}
+
+void PacketFilter::Attach(const Socket &socket) const
+{
+#if BUILD_LINUX == 1
+	std::vector<sock_filter> instructions = Compile();
+	sock_fprog program;
+	program.len = instructions.size();
+	program.filter = instructions.data();
+	if (setsockopt(socket.GetDescriptor(), SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) != 0) {
+		throw std::runtime_error("SO_ATTACH_FILTER setsockopt failed");
+	}
+#else
+	throw std::runtime_error("socket filters are not supported on this platform");
+#endif
+}
+
+#if BUILD_LINUX == 1
+std::vector<sock_filter> PacketFilter::Compile() const
+{
+	// jumps to drop instruction at the end are patched after whole program is emitted
+	std::vector<sock_filter> program;
+	std::vector<size_t> dropJumps;
+
+	program.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0));
+	dropJumps.push_back(program.size());
+	program.push_back(BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, static_cast<uint32_t>(UdpHeaderSize + m_minLength), 0, 0));
+	dropJumps.push_back(program.size());
+	program.push_back(BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K, static_cast<uint32_t>(UdpHeaderSize + m_maxLength), 0, 0));
+
+	// loads beyond packet end make filter drop packet right away, so shorter headers
+	// must be checked first to not reject valid short packets with longer header
+	std::vector<std::string_view> headers = m_headers;
+	std::stable_sort(headers.begin(), headers.end(), [](std::string_view a, std::string_view b) {
+		return a.size() < b.size();
+	});
+
+	for (std::string_view header : headers)
+	{
+		// compare header by words, on mismatch go to the next header block
+		std::vector<size_t> nextJumps;
+		size_t offset = 0;
+		while (offset < header.size())
+		{
+			const size_t remaining = header.size() - offset;
+			const size_t chunkSize = remaining >= 4 ? 4 : (remaining >= 2 ? 2 : 1);
+			const uint16_t loadSize = chunkSize == 4 ? BPF_W : (chunkSize == 2 ? BPF_H : BPF_B);
+			uint32_t value = 0;
+			for (size_t i = 0; i < chunkSize; i++) {
+				value = (value << 8) | static_cast<uint8_t>(header[offset + i]); // loads are in network byte order
+			}
+
+			program.push_back(BPF_STMT(static_cast<uint16_t>(BPF_LD | loadSize | BPF_ABS), static_cast<uint32_t>(UdpHeaderSize + offset)));
+			nextJumps.push_back(program.size());
+			program.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, value, 0, 0));
+			offset += chunkSize;
+		}
+		program.push_back(BPF_STMT(BPF_RET | BPF_K, AcceptPacket));
+
+		for (size_t index : nextJumps) {
+			program[index].jf = program.size() - index - 1;
+		}
+	}
+
+	program.push_back(BPF_STMT(BPF_RET | BPF_K, DropPacket));
+	const size_t dropIndex = program.size() - 1;
+	program[dropJumps[0]].jf = dropIndex - dropJumps[0] - 1;
+	program[dropJumps[1]].jt = dropIndex - dropJumps[1] - 1;
+
+	// jump offsets are just 8-bit, so whole program should be short enough
+	if (program.size() > 256) {
+		throw std::runtime_error("packet filter program is too long");
+	}
+	return program;
+}
+#endif
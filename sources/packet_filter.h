@@ -0,0 +1,45 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "build.h"
+#include "socket.h"
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+
+#if BUILD_LINUX == 1
+#include <linux/filter.h>
+#endif
+
+// in-kernel prefilter for sockets, drops datagrams which doesn't start with any of known headers
+// or have invalid length, so they won't even be copied to userspace
+class PacketFilter
+{
+public:
+	PacketFilter(size_t minLength, size_t maxLength);
+	void AddHeader(std::string_view header);
+	void Attach(const Socket &socket) const;
+
+	static PacketFilter CreateForRequests();
+
+private:
+#if BUILD_LINUX == 1
+	std::vector<sock_filter> Compile() const;
+#endif
+
+	size_t m_minLength;
+	size_t m_maxLength;
+	std::vector<std::string_view> m_headers;
+};
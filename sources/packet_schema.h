@@ -0,0 +1,314 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "binary_input_stream.h"
+#include "binary_output_stream.h"
+#include "infostring_view.h"
+#include <array>
+#include <tuple>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <cstring>
+#include <stdint.h>
+
+// packets are declared as list of fields, and parsing/serialization code is generated 
+// from it at compile time. fixed size fields at the start of packet are checked for 
+// bounds all at once, and only values of fields that carry data are returned in tuple
+namespace PacketSchema
+{
+	// fixed header of packet, it's not compared while parsing because dispatcher already did that
+	template<class Packet> struct Header
+	{
+		static constexpr bool HasValue = false;
+		static constexpr bool IsFixed = true;
+		static constexpr size_t Size = std::char_traits<char>::length(Packet::Header);
+
+		static void Read(BinaryInputStream &stream, size_t) { stream.SkipBytes(Size); }
+		static void Write(BinaryOutputStream &stream) { stream.WriteBytes(Packet::Header, Size); }
+	};
+
+	// single constant byte, like markers of optional blocks
+	template<uint8_t Value> struct Marker
+	{
+		static constexpr bool HasValue = false;
+		static constexpr bool IsFixed = true;
+		static constexpr size_t Size = 1;
+
+		static void Read(BinaryInputStream &stream, size_t) { stream.SkipBytes(Size); }
+		static void Write(BinaryOutputStream &stream) { stream.WriteByte(Value); }
+	};
+
+	template<size_t Count> struct Padding
+	{
+		static constexpr bool HasValue = false;
+		static constexpr bool IsFixed = true;
+		static constexpr size_t Size = Count;
+
+		static void Read(BinaryInputStream &stream, size_t) { stream.SkipBytes(Size); }
+		static void Write(BinaryOutputStream &stream) { stream.WriteByte(0x00, Size); }
+	};
+
+	// integers are in host byte order, same as BinaryInputStream::Read does
+	template<class T> struct Integer
+	{
+		using Value = T;
+		static constexpr bool HasValue = true;
+		static constexpr bool IsFixed = true;
+		static constexpr size_t Size = sizeof(T);
+
+		static Value Decode(const uint8_t *data) 
+		{
+			Value value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		static void Read(BinaryInputStream &stream, Value &value, size_t) { value = stream.Read<T>(); }
+		static void Write(BinaryOutputStream &stream, Value value) { stream.Write<T>(value); }
+	};
+
+	using UInt8 = Integer<uint8_t>;
+	using UInt16 = Integer<uint16_t>;
+	using UInt32 = Integer<uint32_t>;
+
+	// null-terminated string, though terminator could be missing at the end of packet
+	struct String
+	{
+		using Value = std::string_view;
+		static constexpr bool HasValue = true;
+		static constexpr bool IsFixed = false;
+		static constexpr size_t Size = 0;
+
+		static void Read(BinaryInputStream &stream, Value &value, size_t) { stream.ReadStringView(value); }
+		static void Write(BinaryOutputStream &stream, Value value)
+		{
+			stream.WriteBytes(value.data(), value.size());
+			stream.WriteByte(0x00);
+		}
+	};
+
+	// text which takes the rest of packet, written without terminator
+	struct Text
+	{
+		using Value = std::string_view;
+		static constexpr bool HasValue = true;
+		static constexpr bool IsFixed = false;
+		static constexpr size_t Size = 0;
+
+		static void Read(BinaryInputStream &stream, Value &value, size_t) { stream.ReadStringView(value); }
+		static void Write(BinaryOutputStream &stream, Value value) { stream.WriteBytes(value.data(), value.size()); }
+	};
+
+	struct Infostring
+	{
+		using Value = InfostringView;
+		static constexpr bool HasValue = true;
+		static constexpr bool IsFixed = false;
+		static constexpr size_t Size = 0;
+
+		static void Read(BinaryInputStream &stream, Value &value, size_t) 
+		{
+			std::string_view text;
+			if (stream.ReadStringView(text)) {
+				value.Parse(text);
+			}
+		}
+	};
+
+	// raw bytes with length known only in runtime, it is passed to Layout::Parse by caller.
+	// value points to packet buffer, so it's valid only while packet is being handled
+	struct Bytes
+	{
+		using Value = std::pair<const uint8_t*, size_t>;
+		static constexpr bool HasValue = true;
+		static constexpr bool IsFixed = false;
+		static constexpr size_t Size = 0;
+
+		static void Read(BinaryInputStream &stream, Value &value, size_t length) { stream.ReadByteSpan(value, length); }
+		static void Write(BinaryOutputStream &stream, Value value) { stream.WriteBytes(value.first, value.second); }
+	};
+
+	// block of already serialized network addresses, as it's stored in query cache.
+	// it's only referenced by output stream if possible, so it should be alive until packet is sent
+	struct AddressList
+	{
+		using Value = std::pair<const uint8_t*, size_t>; // same as NetAddress::GetAddressSpan
+		static constexpr bool HasValue = true;
+		static constexpr bool IsFixed = false;
+		static constexpr size_t Size = 0;
+
+		static void Write(BinaryOutputStream &stream, Value value) { stream.WriteReference(value.first, value.second); }
+	};
+
+	// field that is present only when there are enough bytes left for it
+	template<class Field> struct Optional
+	{
+		using Value = std::optional<typename Field::Value>;
+		static constexpr bool HasValue = true;
+		static constexpr bool IsFixed = false;
+		static constexpr size_t Size = 0;
+
+		static void Read(BinaryInputStream &stream, Value &value, size_t length) 
+		{
+			static_assert(Field::IsFixed, "only fixed size fields could be optional");
+			const size_t remaining = stream.GetBufferSize() - stream.GetPosition();
+			if (remaining >= Field::Size)
+			{
+				value.emplace();
+				Field::Read(stream, value.value(), length);
+			}
+			else {
+				value = std::nullopt;
+			}
+		}
+
+		static void Write(BinaryOutputStream &stream, const Value &value) 
+		{
+			if (value.has_value()) {
+				Field::Write(stream, value.value());
+			}
+		}
+	};
+
+	// fields without data don't have Value type at all, so it's resolved in such indirect way
+	template<class Field, class = void> struct ValueOf { using Type = void; };
+	template<class Field> struct ValueOf<Field, std::void_t<typename Field::Value>> { using Type = typename Field::Value; };
+
+	template<class Field> 
+	using ValueTuple = std::conditional_t<Field::HasValue, std::tuple<typename ValueOf<Field>::Type>, std::tuple<>>;
+
+	template<class... Fields> class Layout
+	{
+	public:
+		using Values = decltype(std::tuple_cat(std::declval<ValueTuple<Fields>>()...));
+
+		static constexpr size_t FieldsCount = sizeof...(Fields);
+
+		// total size of fixed fields before first variable one, it's checked just once
+		static constexpr size_t PrefixSize = []() {
+			constexpr std::array<bool, FieldsCount + 1> fixed = { Fields::IsFixed..., false };
+			constexpr std::array<size_t, FieldsCount + 1> sizes = { Fields::Size..., 0 };
+			size_t size = 0;
+			for (size_t i = 0; fixed[i]; i++) {
+				size += sizes[i];
+			}
+			return size;
+		}();
+
+		// dynamic length is used by fields which size is known only in runtime, like Bytes
+		static std::optional<Values> Parse(BinaryInputStream &stream, size_t dynamicLength = 0)
+		{
+			Values values;
+			const uint8_t *prefix = stream.Consume(PrefixSize);
+			if (!prefix) {
+				return std::nullopt;
+			}
+
+			ParseFields(stream, prefix, dynamicLength, values, std::index_sequence_for<Fields...>());
+			if (stream.Underflowed()) {
+				return std::nullopt;
+			}
+			return values;
+		}
+
+		static void Serialize(BinaryOutputStream &stream, const Values &values)
+		{
+			SerializeFields(stream, values, std::index_sequence_for<Fields...>());
+		}
+
+	private:
+		template<size_t Index> using FieldAt = std::tuple_element_t<Index, std::tuple<Fields...>>;
+
+		static constexpr bool InPrefix(size_t index)
+		{
+			constexpr std::array<bool, FieldsCount + 1> fixed = { Fields::IsFixed..., false };
+			for (size_t i = 0; i <= index; i++) 
+			{
+				if (!fixed[i]) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		static constexpr size_t OffsetOf(size_t index)
+		{
+			constexpr std::array<size_t, FieldsCount + 1> sizes = { Fields::Size..., 0 };
+			size_t offset = 0;
+			for (size_t i = 0; i < index; i++) {
+				offset += sizes[i];
+			}
+			return offset;
+		}
+
+		static constexpr size_t ValueIndexOf(size_t index)
+		{
+			constexpr std::array<bool, FieldsCount + 1> hasValue = { Fields::HasValue..., false };
+			size_t valueIndex = 0;
+			for (size_t i = 0; i < index; i++) {
+				valueIndex += hasValue[i] ? 1 : 0;
+			}
+			return valueIndex;
+		}
+
+		template<size_t... Indices>
+		static void ParseFields(BinaryInputStream &stream, const uint8_t *prefix, size_t dynamicLength, Values &values, std::index_sequence<Indices...>)
+		{
+			(ParseField<Indices>(stream, prefix, dynamicLength, values), ...);
+		}
+
+		template<size_t Index>
+		static void ParseField(BinaryInputStream &stream, const uint8_t *prefix, size_t dynamicLength, Values &values)
+		{
+			using Field = FieldAt<Index>;
+			if constexpr (InPrefix(Index))
+			{
+				// already bounds-checked, so just decode it from buffer
+				if constexpr (Field::HasValue) {
+					std::get<ValueIndexOf(Index)>(values) = Field::Decode(prefix + OffsetOf(Index));
+				}
+			}
+			else 
+			{
+				if constexpr (Field::HasValue) {
+					Field::Read(stream, std::get<ValueIndexOf(Index)>(values), dynamicLength);
+				}
+				else {
+					Field::Read(stream, dynamicLength);
+				}
+			}
+		}
+
+		template<size_t... Indices>
+		static void SerializeFields(BinaryOutputStream &stream, const Values &values, std::index_sequence<Indices...>)
+		{
+			(SerializeField<Indices>(stream, values), ...);
+		}
+
+		template<size_t Index>
+		static void SerializeField(BinaryOutputStream &stream, const Values &values)
+		{
+			using Field = FieldAt<Index>;
+			if constexpr (Field::HasValue) {
+				Field::Write(stream, std::get<ValueIndexOf(Index)>(values));
+			}
+			else {
+				Field::Write(stream);
+			}
+		}
+	};
+}
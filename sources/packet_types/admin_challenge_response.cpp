@@ -13,7 +13,6 @@ GNU General Public License for more details.
 */
 
 #include "admin_challenge_response.h"
-#include <cstring>
 
 AdminChallengeResponse::AdminChallengeResponse(uint32_t masterChallenge, uint32_t hashChallenge) :
 	m_masterChallenge(masterChallenge),
@@ -23,7 +22,5 @@ AdminChallengeResponse::AdminChallengeResponse(uint32_t masterChallenge, uint32_
 
 void AdminChallengeResponse::Serialize(BinaryOutputStream &stream) const
 {
-	stream.WriteBytes(Header, std::strlen(AdminChallengeResponse::Header));
-	stream.Write<uint32_t>(m_masterChallenge);
-	stream.Write<uint32_t>(m_hashChallenge);
+	Schema::Serialize(stream, { m_masterChallenge, m_hashChallenge });
 }
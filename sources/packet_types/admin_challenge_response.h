@@ -14,6 +14,7 @@ GNU General Public License for more details.
 
 #pragma once
 #include "binary_output_stream.h"
+#include "packet_schema.h"
 #include <stdint.h>
 
 class AdminChallengeResponse
@@ -25,6 +26,12 @@ public:
 	void Serialize(BinaryOutputStream &stream) const;
 
 private:
+	using Schema = PacketSchema::Layout<
+		PacketSchema::Header<AdminChallengeResponse>,
+		PacketSchema::UInt32, // master challenge
+		PacketSchema::UInt32 // hash challenge
+	>;
+
 	uint32_t m_masterChallenge;
 	uint32_t m_hashChallenge;
 };
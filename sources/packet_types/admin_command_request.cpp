@@ -13,19 +13,18 @@ GNU General Public License for more details.
 */
 
 #include "admin_command_request.h"
-#include <cstring>
 
 std::optional<AdminCommandRequest> AdminCommandRequest::Parse(BinaryInputStream &stream, size_t hashLength)
 {
-	AdminCommandRequest object;
-
-	stream.SkipBytes(std::strlen(AdminCommandRequest::Header));
-	object.m_challenge = stream.Read<uint32_t>();
-	stream.ReadBytes(object.m_hash.data(), hashLength);
-	stream.ReadString(object.m_command);
-
-	if (stream.Underflowed()) {
+	auto fields = Schema::Parse(stream, hashLength);
+	if (!fields.has_value()) {
 		return std::nullopt;
 	}
+
+	AdminCommandRequest object;
+	const auto &[challenge, hash, command] = fields.value();
+	object.m_challenge = challenge;
+	object.m_hash = hash.first;
+	object.m_command = command;
 	return object;
 }
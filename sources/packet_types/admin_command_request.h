@@ -14,8 +14,8 @@ GNU General Public License for more details.
 
 #pragma once
 #include "binary_input_stream.h"
-#include <array>
-#include <string>
+#include "packet_schema.h"
+#include <string_view>
 #include <optional>
 #include <stdint.h>
 
@@ -28,13 +28,20 @@ public:
 
 	static std::optional<AdminCommandRequest> Parse(BinaryInputStream &stream, size_t hashLength);
 	uint32_t GetMasterChallenge() const { return m_challenge; }
-	const std::string& GetCommand() const { return m_command; }
-	const uint8_t *GetHash() const { return m_hash.data(); }
+	std::string_view GetCommand() const { return m_command; } // points to request buffer
+	const uint8_t *GetHash() const { return m_hash; } // same as above
 
 private:
+	using Schema = PacketSchema::Layout<
+		PacketSchema::Header<AdminCommandRequest>,
+		PacketSchema::UInt32, // master challenge
+		PacketSchema::Bytes, // hash, length depends on config
+		PacketSchema::String // command
+	>;
+
 	AdminCommandRequest() = default;
 
 	uint32_t m_challenge;
-	std::string m_command;
-	std::array<uint8_t, 64> m_hash;
+	std::string_view m_command;
+	const uint8_t *m_hash;
 };
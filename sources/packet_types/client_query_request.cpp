@@ -12,43 +12,28 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
 GNU General Public License for more details.
 */
 
-#include <scn/scan.h>
 #include "client_query_request.h"
+#include "utils.h"
 
 // such function is an experimental approach to RAII without exceptions
 std::optional<ClientQueryRequest> ClientQueryRequest::Parse(BinaryInputStream &stream)
 {
-	ClientQueryRequest object;
-	std::string queryInfo;
-
-	stream.SkipBytes(2); // skip header
-	if (stream.EndOfFile()) {
+	auto fields = Schema::Parse(stream);
+	if (!fields.has_value()) {
 		return std::nullopt;
 	}
 
-	if (!stream.SkipString()) { // placeholder addr, ignored
-		return std::nullopt;
-	}
-
-	if (!stream.ReadString(queryInfo)) {
-		return std::nullopt; 
-	}
-
-	size_t slashPos = queryInfo.find_first_of('\\');
-	if (slashPos == std::string::npos) {
-		return std::nullopt;
-	}
-
-	InfostringData data(queryInfo);
+	ClientQueryRequest object;
+	const InfostringView &data = std::get<InfostringView>(fields.value());
 	if (!object.ValidateInfostring(data)) {
 		return std::nullopt; 
 	}
 
-	if (data["key"].has_value())
+	if (data[InfostringKey::Key].has_value())
 	{
-		auto scan = scn::scan_int<uint32_t>(data["key"].value(), 16);
+		auto scan = Utils::ParseInteger<uint32_t>(data[InfostringKey::Key].value(), 16);
 		if (scan.has_value()) {
-			object.m_queryKey = scan->value();
+			object.m_queryKey = scan.value();
 		}
 		else {
 			return std::nullopt; // invalid data in query key
@@ -58,11 +43,11 @@ std::optional<ClientQueryRequest> ClientQueryRequest::Parse(BinaryInputStream &s
 		object.m_queryKey = std::nullopt;
 	}
 	
-	if (data["protocol"].has_value()) 
+	if (data[InfostringKey::Protocol].has_value()) 
 	{
-		auto scan = scn::scan_int<uint32_t>(data["protocol"].value());
+		auto scan = Utils::ParseInteger<uint32_t>(data[InfostringKey::Protocol].value());
 		if (scan.has_value()) {
-			object.m_protocolVersion = scan->value();
+			object.m_protocolVersion = scan.value();
 		}
 		else {
 			return std::nullopt; // invalid protocol number
@@ -72,25 +57,40 @@ std::optional<ClientQueryRequest> ClientQueryRequest::Parse(BinaryInputStream &s
 		object.m_protocolVersion = std::nullopt;
 	}
 
-	if (data["clver"].has_value()) {
-		object.m_clientVersion = VersionInfo::Parse(data["clver"].value());
+	// clients which are able to receive list split into pages should request them explicitly
+	if (data[InfostringKey::Page].has_value()) 
+	{
+		auto scan = Utils::ParseInteger<uint16_t>(data[InfostringKey::Page].value());
+		if (scan.has_value()) {
+			object.m_page = scan.value();
+		}
+		else {
+			return std::nullopt; // invalid page number
+		}
+	}
+	else {
+		object.m_page = std::nullopt;
+	}
+
+	if (data[InfostringKey::Clver].has_value()) {
+		object.m_clientVersion = VersionInfo::Parse(data[InfostringKey::Clver].value());
 	}
 	else {
 		object.m_clientVersion = std::nullopt;
 	}
 
-	object.m_clientBypassingNat = data["nat"].value().compare("0") != 0;
-	object.m_gamedir = data["gamedir"].value();
+	auto filter = ServerFilter::Parse(data);
+	if (!filter.has_value()) {
+		return std::nullopt;
+	}
+
+	object.m_filter = filter.value();
+	object.m_clientBypassingNat = data[InfostringKey::Nat].value() != "0";
+	object.m_gamedir = data[InfostringKey::Gamedir].value();
 	return object;
 }
 
-bool ClientQueryRequest::ValidateInfostring(const InfostringData &data) const
+bool ClientQueryRequest::ValidateInfostring(const InfostringView &data) const
 {
-	if (!data["gamedir"].has_value()) {
-		return false;
-	}
-	if (!data["nat"].has_value()) {
-		return false;
-	}
-	return true;
+	return data.Contains(InfostringKeys::Mask(InfostringKey::Gamedir, InfostringKey::Nat));
 }
@@ -14,8 +14,10 @@ GNU General Public License for more details.
 
 #pragma once
 #include "binary_input_stream.h"
-#include "infostring_data.h"
+#include "infostring_view.h"
 #include "version_info.h"
+#include "server_filter.h"
+#include "packet_schema.h"
 #include <optional>
 #include <stdint.h>
 
@@ -26,21 +28,32 @@ public:
 	static std::optional<ClientQueryRequest> Parse(BinaryInputStream& stream);
 
 	bool ClientBypassingNat() const { return m_clientBypassingNat; }
-	const std::string &GetGamedir() const { return m_gamedir; }
+	std::string_view GetGamedir() const { return m_gamedir; } // points to request buffer
 	std::optional<uint32_t> GetQueryKey() const { return m_queryKey; };
 	std::optional<uint32_t> GetProtocolVersion() const { return m_protocolVersion; }
+	std::optional<uint16_t> GetPage() const { return m_page; }
 	std::optional<VersionInfo> GetClientVersion() const { return m_clientVersion; }
+	const ServerFilter &GetFilter() const { return m_filter; }
 
 	static constexpr const char *Header = "1";
 
 private:
+	using Schema = PacketSchema::Layout<
+		PacketSchema::Header<ClientQueryRequest>,
+		PacketSchema::UInt8, // region, ignored
+		PacketSchema::String, // placeholder address, ignored
+		PacketSchema::Infostring
+	>;
+
 	ClientQueryRequest() = default;
 
-	bool ValidateInfostring(const InfostringData &data) const;
+	bool ValidateInfostring(const InfostringView &data) const;
 
 	bool m_clientBypassingNat;
-	std::string m_gamedir;
+	std::string_view m_gamedir;
 	std::optional<uint32_t> m_queryKey;
 	std::optional<uint32_t> m_protocolVersion;
+	std::optional<uint16_t> m_page;
 	std::optional<VersionInfo> m_clientVersion;
+	ServerFilter m_filter;
 };
@@ -13,60 +13,47 @@ GNU General Public License for more details.
 */
 
 #include "client_query_response.h"
+#include <algorithm>
 
-ClientQueryResponse::ClientQueryResponse(bool natBypass, 
-	std::optional<uint32_t> queryKey, 
-	std::optional<uint32_t> clientProtocol, 
-	const NetAddress &clientAddr, 
-	const ServerList::EntryContainer &servers, 
-	const std::string &gamedir) :
+// header, query key block, page block and end of message marker
+static constexpr size_t MaxResponseOverhead = 6 + 6 + 6 + 6;
+
+ClientQueryResponse::ClientQueryResponse(std::optional<uint32_t> queryKey, 
+	std::optional<uint16_t> page,
+	size_t maxPacketSize,
+	const ServerQueryResult &result) :
 	m_queryKey(queryKey),
-	m_clientProtocol(clientProtocol),
-	m_clientAddress(clientAddr),
-	m_natBypassMode(natBypass),
-	m_gamedir(gamedir),
-	m_servers(servers)
+	m_page(page),
+	m_pagesCount(1),
+	m_firstServer(0),
+	m_serversCount(result.addresses.size() / result.addressSize),
+	m_result(result)
 {
+	if (m_page.has_value())
+	{
+		const size_t totalCount = m_serversCount;
+		const size_t pageCapacity = std::max<size_t>((maxPacketSize - std::min(maxPacketSize, MaxResponseOverhead)) / result.addressSize, 1);
+		const size_t pagesCount = std::max<size_t>((totalCount + pageCapacity - 1) / pageCapacity, 1);
+		m_pagesCount = std::min<size_t>(pagesCount, UINT16_MAX);
+		m_firstServer = std::min<size_t>(m_page.value() * pageCapacity, totalCount);
+		m_serversCount = std::min(pageCapacity, totalCount - m_firstServer);
+	}
 }
 
-void ClientQueryResponse::Serialize(BinaryOutputStream &stream, std::vector<NetAddress> &natServers) const
+void ClientQueryResponse::Serialize(BinaryOutputStream &stream) const
 {
-	stream.WriteString(ClientQueryResponse::Header);
-	if (m_queryKey.has_value())
-	{
-		stream.WriteByte(0x7F);
-		stream.Write<uint32_t>(m_queryKey.value());
-		stream.WriteByte(0x00);
+	HeaderSchema::Serialize(stream, {});
+	if (m_queryKey.has_value()) {
+		QueryKeySchema::Serialize(stream, { m_queryKey.value() });
 	}
 
-	// TODO implement pagination mechanism to bypass MTU limit, when servers count are huge
-	// but for November 2024, engine still does not supports such mechanism
-	// for more information see CL_ServerList function in engine sources
-	natServers.clear();
-	for (const auto &[serverAddr, entry] : m_servers)
-	{
-		if (serverAddr.GetAddressFamily() != m_clientAddress.GetAddressFamily())
-			continue;
-
-		if (entry.NatBypassEnabled() != m_natBypassMode)
-			continue;
-
-		if (m_gamedir.compare(entry.GetGamedir()) != 0)
-			continue;
-
-		if (m_clientProtocol.has_value())
-		{
-			if (entry.GetProtocolVersion() != m_clientProtocol.value()) {
-				continue;
-			}
-		}
-
-		if (m_natBypassMode) {
-			natServers.push_back(serverAddr);
-		}
-		stream.WriteNetAddress(serverAddr);
+	// legacy clients get whole list at once, because engine before pagination support
+	// doesn't expect anything after the first packet (see CL_ServerList function in engine sources).
+	// clients which requested page get only its slice, so every packet fits into MTU
+	if (m_page.has_value()) {
+		PageSchema::Serialize(stream, { m_page.value(), m_pagesCount });
 	}
-
-	// write null address as an end of message marker
-	stream.WriteByte(0x00, 6);
+	
+	const uint8_t *addresses = m_result.addresses.data() + m_firstServer * m_result.addressSize;
+	ServersSchema::Serialize(stream, { std::make_pair(addresses, m_serversCount * m_result.addressSize) });
 }
@@ -15,9 +15,8 @@ GNU General Public License for more details.
 #pragma once
 #include "binary_output_stream.h"
 #include "net_address.h"
-#include "server_list.h"
-#include <vector>
-#include <string>
+#include "query_cache.h"
+#include "packet_schema.h"
 #include <optional>
 #include <stdint.h>
 
@@ -26,20 +25,37 @@ class ClientQueryResponse
 public:
 	static constexpr const char *Header = "\xff\xff\xff\xff" "f\n";
 
-	ClientQueryResponse(bool natBypass,
-		std::optional<uint32_t> queryKey,
-		std::optional<uint32_t> clientProtocol,
-		const NetAddress &clientAddr,
-		const ServerList::EntryContainer &servers, 
-		const std::string &gamedir);
+	ClientQueryResponse(std::optional<uint32_t> queryKey, 
+		std::optional<uint16_t> page,
+		size_t maxPacketSize,
+		const ServerQueryResult &result);
 
-	void Serialize(BinaryOutputStream &stream, std::vector<NetAddress> &natServers) const;
+	void Serialize(BinaryOutputStream &stream) const;
+	size_t GetFirstServerIndex() const { return m_firstServer; }
+	size_t GetServersCount() const { return m_serversCount; }
 
 private:
-	bool m_natBypassMode;
-	NetAddress m_clientAddress;
-	std::string m_gamedir;
+	using HeaderSchema = PacketSchema::Layout<PacketSchema::Header<ClientQueryResponse>>;
+	using QueryKeySchema = PacketSchema::Layout<
+		PacketSchema::Marker<0x7F>,
+		PacketSchema::UInt32, // query key
+		PacketSchema::Marker<0x00>
+	>;
+	using PageSchema = PacketSchema::Layout<
+		PacketSchema::Marker<0x7E>,
+		PacketSchema::UInt16, // page index
+		PacketSchema::UInt16, // pages count
+		PacketSchema::Marker<0x00>
+	>;
+	using ServersSchema = PacketSchema::Layout<
+		PacketSchema::AddressList,
+		PacketSchema::Padding<6> // null address as an end of message marker
+	>;
+
 	std::optional<uint32_t> m_queryKey;
-	std::optional<uint32_t> m_clientProtocol;
-	const ServerList::EntryContainer &m_servers;
+	std::optional<uint16_t> m_page;
+	uint16_t m_pagesCount;
+	size_t m_firstServer;
+	size_t m_serversCount;
+	const ServerQueryResult &m_result;
 };
@@ -12,91 +12,45 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
 GNU General Public License for more details.
 */
 
-#include <scn/scan.h>
 #include "server_append_request.h"
+#include "utils.h"
 
 std::optional<ServerAppendRequest> ServerAppendRequest::Parse(BinaryInputStream &stream)
 {
-	InfostringData data;
-	ServerAppendRequest object;
-	std::string infostring;
-
-	stream.SkipBytes(2); // skip header bytes
-	if (stream.EndOfFile()) {
+	auto fields = Schema::Parse(stream);
+	if (!fields.has_value()) {
 		return std::nullopt; // invalid request length
 	}
 
-	stream.ReadString(infostring); // this string in request is not null-terminated
-	data.Parse(infostring);
+	ServerAppendRequest object;
+	const auto &[data] = fields.value();
 	if (!object.ValidateInfostring(data)) {
 		return std::nullopt; // request infostring correctness and fullness check failed
 	}
 
-	auto version = VersionInfo::Parse(data["version"].value());
+	auto version = VersionInfo::Parse(data[InfostringKey::Version].value());
 	if (!version.has_value()) {
 		return std::nullopt; // error while parsing version info
 	}
 
-	auto challenge = scn::scan_int<uint32_t>(data["challenge"].value());
+	auto challenge = Utils::ParseInteger<uint32_t>(data[InfostringKey::Challenge].value());
 	if (!challenge.has_value()) {
 		return std::nullopt; // error while parsing challenge data
 	}
 
-	object.m_challenge = challenge->value();
+	object.m_challenge = challenge.value();
 	object.m_serverVersion = version.value();
-	object.m_infostringData = std::move(data);
+	object.m_infostringData = data;
 	return object;
 }
 
-bool ServerAppendRequest::ValidateInfostring(const InfostringData &data)
+bool ServerAppendRequest::ValidateInfostring(const InfostringView &data)
 {
-	if (!data["challenge"].has_value()) {
-		return false;
-	}
-	if (!data["protocol"].has_value()) {
-		return false;
-	}
-	if (!data["players"].has_value()) {
-		return false;
-	}
-	if (!data["max"].has_value()) {
-		return false;
-	}
-	if (!data["bots"].has_value()) {
-		return false;
-	}
-	if (!data["region"].has_value()) {
-		return false;
-	}
-	if (!data["gamedir"].has_value()) {
-		return false;
-	}
-	if (!data["map"].has_value()) {
-		return false;
-	}
-	if (!data["version"].has_value()) {
-		return false;
-	}
-	if (!data["os"].has_value()) {
-		return false;
-	}
-	if (!data["product"].has_value()) {
-		return false;
-	}
-	if (!data["type"].has_value()) {
-		return false;
-	}
-	if (!data["password"].has_value()) {
-		return false;
-	}
-	if (!data["secure"].has_value()) {
-		return false;
-	}
-	if (!data["lan"].has_value()) {
-		return false;
-	}
-	if (!data["nat"].has_value()) {
-		return false;
-	}
-	return true;
+	constexpr uint32_t requiredKeys = InfostringKeys::Mask(
+		InfostringKey::Challenge, InfostringKey::Protocol, InfostringKey::Players, InfostringKey::Max,
+		InfostringKey::Bots, InfostringKey::Region, InfostringKey::Gamedir, InfostringKey::Map,
+		InfostringKey::Version, InfostringKey::Os, InfostringKey::Product, InfostringKey::Type,
+		InfostringKey::Password, InfostringKey::Secure, InfostringKey::Lan, InfostringKey::Nat
+	);
+	return data.Contains(requiredKeys);
 }
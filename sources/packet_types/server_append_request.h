@@ -14,8 +14,9 @@ GNU General Public License for more details.
 
 #pragma once
 #include "binary_input_stream.h"
-#include "infostring_data.h"
+#include "infostring_view.h"
 #include "version_info.h"
+#include "packet_schema.h"
 #include <optional>
 #include <stdint.h>
 
@@ -26,17 +27,22 @@ public:
 	static std::optional<ServerAppendRequest> Parse(BinaryInputStream &stream);
 
 	uint32_t GetMasterChallenge() const { return m_challenge; }
-	const InfostringData &GetInfostringData() const { return m_infostringData; }
+	const InfostringView &GetInfostringData() const { return m_infostringData; } // points to request buffer
 	const VersionInfo &GetServerVersion() const { return m_serverVersion; }
 
 	static constexpr const char *Header = "0\n";
 
 private:
+	using Schema = PacketSchema::Layout<
+		PacketSchema::Header<ServerAppendRequest>,
+		PacketSchema::Infostring // this string in request is not null-terminated
+	>;
+
 	ServerAppendRequest() = default;
 
-	bool ValidateInfostring(const InfostringData &data);
+	bool ValidateInfostring(const InfostringView &data);
 
 	uint32_t m_challenge;
 	VersionInfo m_serverVersion;
-	InfostringData m_infostringData;
+	InfostringView m_infostringData;
 };
@@ -16,14 +16,12 @@ GNU General Public License for more details.
 
 std::optional<ServerChallengeRequest> ServerChallengeRequest::Parse(BinaryInputStream &stream)
 {
-	ServerChallengeRequest object;
-	if (stream.GetBufferSize() == 6)
-	{	
-		stream.SkipBytes(2); // skip header
-		object.m_clientChallenge = stream.Read<uint32_t>(); // read client challenge 
-	}
-	else {
-		object.m_clientChallenge = std::nullopt;
+	auto fields = Schema::Parse(stream);
+	if (!fields.has_value()) {
+		return std::nullopt;
 	}
+
+	ServerChallengeRequest object;
+	std::tie(object.m_clientChallenge) = fields.value();
 	return object;
 }
@@ -14,6 +14,7 @@ GNU General Public License for more details.
 
 #pragma once
 #include "binary_input_stream.h"
+#include "packet_schema.h"
 #include <optional>
 #include <stdint.h>
 
@@ -28,6 +29,11 @@ public:
 	static constexpr const char *Header = "q\xff";
 
 private:
+	using Schema = PacketSchema::Layout<
+		PacketSchema::Header<ServerChallengeRequest>,
+		PacketSchema::Optional<PacketSchema::UInt32> // client challenge, only newer engines send it
+	>;
+
 	ServerChallengeRequest() = default;
 
 	std::optional<uint32_t> m_clientChallenge;
@@ -22,9 +22,5 @@ ServerChallengeResponse::ServerChallengeResponse(uint32_t challenge, std::option
 
 void ServerChallengeResponse::Serialize(BinaryOutputStream &stream) const
 {
-	stream.WriteString(ServerChallengeResponse::Header);
-	stream.Write<uint32_t>(m_challenge);
-	if (m_clientChallenge.has_value()) {
-		stream.Write<uint32_t>(m_clientChallenge.value());
-	}
+	Schema::Serialize(stream, { m_challenge, m_clientChallenge });
 }
@@ -14,6 +14,7 @@ GNU General Public License for more details.
 
 #pragma once
 #include "binary_output_stream.h"
+#include "packet_schema.h"
 #include <optional>
 #include <stdint.h>
 
@@ -26,6 +27,12 @@ public:
 	void Serialize(BinaryOutputStream &stream) const;
 
 private:
+	using Schema = PacketSchema::Layout<
+		PacketSchema::Header<ServerChallengeResponse>,
+		PacketSchema::UInt32, // master challenge
+		PacketSchema::Optional<PacketSchema::UInt32> // client challenge, only when server sent it
+	>;
+
 	uint32_t m_challenge;
 	std::optional<uint32_t> m_clientChallenge;
 };
@@ -23,6 +23,5 @@ ServerNatAnnounce::ServerNatAnnounce(const NetAddress &clientAddress) :
 void ServerNatAnnounce::Serialize(BinaryOutputStream &stream) const
 {
 	std::string addrString = fmt::format("{}:{}", m_clientAddress.ToString(), m_clientAddress.GetPort());
-	stream.WriteString(ServerNatAnnounce::Header);
-	stream.WriteBytes(addrString.c_str(), addrString.size());
+	Schema::Serialize(stream, { addrString });
 }
@@ -15,6 +15,7 @@ GNU General Public License for more details.
 #pragma once
 #include "net_address.h"
 #include "binary_output_stream.h"
+#include "packet_schema.h"
 
 class ServerNatAnnounce
 {
@@ -25,5 +26,10 @@ public:
 	void Serialize(BinaryOutputStream &stream) const;
 
 private:
+	using Schema = PacketSchema::Layout<
+		PacketSchema::Header<ServerNatAnnounce>,
+		PacketSchema::Text // client address and port
+	>;
+
 	NetAddress m_clientAddress;
 };
@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "query_cache.h"
+#include <functional>
+
+bool ServerQuery::operator==(const ServerQuery &rhs) const
+{
+	return family == rhs.family && 
+		natBypass == rhs.natBypass && 
+		protocol == rhs.protocol && 
+		gamedir == rhs.gamedir;
+}
+
+std::size_t ServerQueryHash::operator()(const ServerQuery &query) const noexcept
+{
+	std::size_t hash = std::hash<std::string>{}(query.gamedir);
+	hash ^= std::hash<uint32_t>{}(query.protocol.value_or(0)) << 1;
+	hash ^= static_cast<std::size_t>(query.protocol.has_value()) << 2;
+	hash ^= static_cast<std::size_t>(query.natBypass) << 3;
+	hash ^= static_cast<std::size_t>(query.family) << 4;
+	return hash;
+}
+
+std::shared_ptr<const ServerQueryResult> QueryCache::Find(const ServerQuery &query) const
+{
+	std::lock_guard lock(m_mutex);
+	auto it = m_results.find(query);
+	if (it != m_results.end()) {
+		return it->second;
+	}
+	return nullptr;
+}
+
+void QueryCache::Store(const ServerQuery &query, std::shared_ptr<const ServerQueryResult> result)
+{
+	std::lock_guard lock(m_mutex);
+	if (m_results.size() >= MaxResultsCount) {
+		m_results.clear();
+	}
+	m_results[query] = std::move(result);
+}
+
+void QueryCache::Invalidate(NetAddress::AddressFamily family, const std::string &gamedir)
+{
+	// there are just a few distinct queries usually, so it's fine to check all of them
+	std::lock_guard lock(m_mutex);
+	for (auto it = m_results.begin(); it != m_results.end();)
+	{
+		if (it->first.family == family && it->first.gamedir == gamedir) {
+			it = m_results.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+}
+
+void QueryCache::Clear()
+{
+	std::lock_guard lock(m_mutex);
+	m_results.clear();
+}
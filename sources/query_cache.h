@@ -0,0 +1,64 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "net_address.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <stdint.h>
+
+// parameters of client query which determine set of servers in response
+struct ServerQuery
+{
+	NetAddress::AddressFamily family;
+	std::string gamedir;
+	std::optional<uint32_t> protocol;
+	bool natBypass;
+
+	bool operator==(const ServerQuery &rhs) const;
+};
+
+class ServerQueryHash
+{
+public:
+	std::size_t operator()(const ServerQuery &query) const noexcept;
+};
+
+struct ServerQueryResult
+{
+	std::vector<uint8_t> addresses; // already serialized addresses list, ready to be copied into response
+	std::vector<NetAddress> natServers; // matches addresses order, if query is for NAT servers
+	size_t addressSize = 6; // size of single serialized address with port
+};
+
+// keeps results of recently processed queries until any of matching servers gets changed.
+// it has own lock because results are stored while server list is only locked for reading
+class QueryCache
+{
+public:
+	std::shared_ptr<const ServerQueryResult> Find(const ServerQuery &query) const;
+	void Store(const ServerQuery &query, std::shared_ptr<const ServerQueryResult> result);
+	void Invalidate(NetAddress::AddressFamily family, const std::string &gamedir);
+	void Clear();
+
+private:
+	static constexpr size_t MaxResultsCount = 256; // protects from flood with random gamedirs
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<ServerQuery, std::shared_ptr<const ServerQueryResult>, ServerQueryHash> m_results;
+};
@@ -15,18 +15,37 @@ GNU General Public License for more details.
 #include "request_handler.h"
 #include "binary_input_stream.h"
 #include "binary_output_stream.h"
+#include "infostring_data.h"
 #include "admin_challenge_request.h"
 #include "admin_challenge_response.h"
 #include "server_challenge_response.h"
 #include "server_nat_announce.h"
 #include "client_query_response.h"
 #include "utils.h"
+#include <mutex>
+#include <shared_mutex>
 
 RequestHandler::RequestHandler(ServerList &serverList, ConfigManager &configManager) :
 	m_serverList(serverList),
 	m_configManager(configManager),
-	m_adminCommandHandler(serverList, configManager, m_banlist)
+	m_adminCommandHandler(serverList, configManager)
 {
+	auto route = [this](void (RequestHandler::*handler)(Socket&, const Datagram&)) {
+		return [this, handler](Socket &socket, const Datagram &datagram) {
+			(this->*handler)(socket, datagram);
+		};
+	};
+
+	m_dispatcher.Register(RequestType::ClientQuery, route(&RequestHandler::HandleClientQuery));
+	m_dispatcher.Register(RequestType::ServerChallenge, route(&RequestHandler::HandleServerChallenge));
+	m_dispatcher.Register(RequestType::ServerAppend, route(&RequestHandler::HandleServerAppend));
+	m_dispatcher.Register(RequestType::AdminChallenge, route(&RequestHandler::HandleAdminChallenge));
+	m_dispatcher.Register(RequestType::AdminCommand, route(&RequestHandler::HandleAdminCommand));
+
+	// nobody could pass authentication anyway, so don't even spend time on these requests
+	const bool adminsConfigured = !m_configManager.GetData().GetAdmins().empty();
+	m_dispatcher.SetEnabled(RequestType::AdminChallenge, adminsConfigured);
+	m_dispatcher.SetEnabled(RequestType::AdminCommand, adminsConfigured);
 }
 
 void RequestHandler::UpdateState()
@@ -35,74 +54,87 @@ void RequestHandler::UpdateState()
 	m_packetRateMap.clear();
 }
 
-void RequestHandler::HandlePacket(Socket &socket, const NetAddress &sourceAddr)
+void RequestHandler::HandlePacket(Socket &socket, const Datagram &datagram)
 {
-	if (m_banlist.count(sourceAddr) > 0) {
-		return; // ignore packets from banned addresses
-	}
-	else {
-		m_packetRateMap[sourceAddr] += 1; // count packet rate for this address in case we'll need it somewhen
+	const NetAddress &sourceAddr = datagram.source;
+	{
+		std::shared_lock lock(m_serverList.GetMutex());
+		if (m_serverList.IsBanned(sourceAddr)) {
+			return; // ignore packets from banned addresses
+		}
 	}
+	m_packetRateMap[sourceAddr] += 1; // count packet rate for this address in case we'll need it somewhen
 
-	auto &recvBuffer = socket.GetDataBuffer();
-	if (recvBuffer.size() < 2) {
+	if (datagram.size < 2) {
 		return; // invalid size packet, ignore it
 	}
-	HandleRequest(socket, sourceAddr);
+	m_dispatcher.Dispatch(socket, datagram);
 }
 
-void RequestHandler::HandleRequest(Socket &socket, const NetAddress &sourceAddr)
+void RequestHandler::HandleClientQuery(Socket &socket, const Datagram &datagram)
 {
-	auto &recvBuffer = socket.GetDataBuffer();
-	BinaryInputStream stream(recvBuffer.data(), recvBuffer.size());
-	if (std::memcmp(recvBuffer.data(), ClientQueryRequest::Header, 1) == 0)
+	BinaryInputStream stream(datagram.data, datagram.size);
+	auto request = ClientQueryRequest::Parse(stream);
+	if (request.has_value()) 
 	{
-		auto request = ClientQueryRequest::Parse(stream);
-		if (request.has_value()) {
-			ProcessClientQuery(socket, sourceAddr, request.value());
-		}
+		std::shared_lock lock(m_serverList.GetMutex());
+		ProcessClientQuery(socket, datagram.source, request.value());
 	}
-	else if (std::memcmp(recvBuffer.data(), ServerChallengeRequest::Header, 2) == 0) 
-	{
-		if (m_serverList.GetCountForAddress(sourceAddr) >= m_configManager.GetData().GetServerCountQuota()) {
-			return; // too much servers for this IP address
-		}
-		else if (m_serverList.CheckForChallenge(sourceAddr)) {
-			return; // this server already got challenge
-		}
+}
 
-		auto request = ServerChallengeRequest::Parse(stream);
-		if (request.has_value()) {
-			ProcessChallengeRequest(socket, sourceAddr, request.value());
-		}
+void RequestHandler::HandleServerChallenge(Socket &socket, const Datagram &datagram)
+{
+	const NetAddress &sourceAddr = datagram.source;
+	BinaryInputStream stream(datagram.data, datagram.size);
+	std::unique_lock lock(m_serverList.GetMutex());
+	if (m_serverList.GetCountForAddress(sourceAddr) >= m_configManager.GetData().GetServerCountQuota()) {
+		return; // too much servers for this IP address
+	}
+	else if (m_serverList.CheckForChallenge(sourceAddr)) {
+		return; // this server already got challenge
 	}
-	else if (std::memcmp(recvBuffer.data(), ServerAppendRequest::Header, 2) == 0)
-	{
-		if (!m_serverList.CheckForChallenge(sourceAddr)) 
-		{
-			Utils::Log("Server skipped challenge request: {}:{}\n", sourceAddr.ToString(), sourceAddr.GetPort());
-			return;
-		}
 
-		auto request = ServerAppendRequest::Parse(stream);
-		if (request.has_value()) {
-			ProcessAddServerRequest(socket, sourceAddr, request.value());
-		}
+	auto request = ServerChallengeRequest::Parse(stream);
+	if (request.has_value()) {
+		ProcessChallengeRequest(socket, sourceAddr, request.value());
 	}
-	else if (std::memcmp(recvBuffer.data(), AdminChallengeRequest::Header, 14) == 0) 
+}
+
+void RequestHandler::HandleServerAppend(Socket &socket, const Datagram &datagram)
+{
+	const NetAddress &sourceAddr = datagram.source;
+	BinaryInputStream stream(datagram.data, datagram.size);
+	std::unique_lock lock(m_serverList.GetMutex());
+	if (!m_serverList.StatelessChallengesEnabled() && !m_serverList.CheckForChallenge(sourceAddr)) 
 	{
-		ProcessAdminChallengeRequest(socket, sourceAddr);
+		Utils::Log("Server skipped challenge request: {}:{}\n", sourceAddr.ToString(), sourceAddr.GetPort());
+		return;
 	}
-	else if (std::memcmp(recvBuffer.data(), AdminCommandRequest::Header, 5) == 0) 
-	{
-		if (!m_serverList.CheckAdminChallenge(sourceAddr)) {
-			return;
-		}
 
-		auto request = AdminCommandRequest::Parse(stream, m_configManager.GetData().GetAdminHashLength());
-		if (request.has_value()) {
-			ProcessAdminCommandRequest(sourceAddr, request.value());
-		}
+	auto request = ServerAppendRequest::Parse(stream);
+	if (request.has_value()) {
+		ProcessAddServerRequest(socket, sourceAddr, request.value());
+	}
+}
+
+void RequestHandler::HandleAdminChallenge(Socket &socket, const Datagram &datagram)
+{
+	std::unique_lock lock(m_serverList.GetMutex());
+	ProcessAdminChallengeRequest(socket, datagram.source);
+}
+
+void RequestHandler::HandleAdminCommand(Socket &socket, const Datagram &datagram)
+{
+	const NetAddress &sourceAddr = datagram.source;
+	BinaryInputStream stream(datagram.data, datagram.size);
+	std::unique_lock lock(m_serverList.GetMutex());
+	if (!m_serverList.StatelessChallengesEnabled() && !m_serverList.CheckAdminChallenge(sourceAddr)) {
+		return;
+	}
+
+	auto request = AdminCommandRequest::Parse(stream, m_configManager.GetData().GetAdminHashLength());
+	if (request.has_value()) {
+		ProcessAdminCommandRequest(sourceAddr, request.value());
 	}
 }
 
@@ -112,7 +144,6 @@ void RequestHandler::ProcessClientQuery(Socket &socket, const NetAddress &source
 	if (clientVersion.has_value() && clientVersion >= m_configManager.GetData().GetClientMinimalVersion()) 
 	{
 		SendClientQueryResponse(socket, sourceAddr, request);
-		SendNatAnnouncements(socket, sourceAddr);
 	}
 	else {
 		SendFakeServerInfo(socket, sourceAddr, request.GetGamedir());
@@ -153,9 +184,7 @@ void RequestHandler::ProcessAddServerRequest(Socket &socket, const NetAddress &s
 	}
 
 	bool serverExists = m_serverList.Contains(sourceAddr);
-	ServerEntry &server = m_serverList.Insert(sourceAddr);
-	server.Update(request.GetInfostringData()); 
-	server.ResetTimeout();
+	ServerEntry &server = m_serverList.Update(sourceAddr, request.GetInfostringData());
 
 	Utils::Log(serverExists ? "Updated " : "Added ");
 	Utils::Log("server: {}:{}, game={}/{}, protocol={}, players={}/{}/{}, version={}\n", 
@@ -176,59 +205,59 @@ void RequestHandler::ProcessAdminChallengeRequest(Socket &socket, const NetAddre
 		return; 
 	}
 
-	uint8_t buffer[64];
-	BinaryOutputStream stream(buffer, sizeof(buffer));
 	AdminChallenge challenge = m_serverList.GetAdminChallenge(sourceAddr);
-
+	BinaryOutputStream stream = socket.PrepareSend();
 	AdminChallengeResponse response(challenge.master, challenge.hash);
 	response.Serialize(stream);
-	socket.SendTo(sourceAddr, stream.GetBuffer(), stream.GetLength());
+	socket.CommitSend(sourceAddr, stream);
 }
 
 void RequestHandler::ProcessAdminCommandRequest(const NetAddress &sourceAddr, AdminCommandRequest &request)
 {
-	auto challenge = m_serverList.GetAdminChallenge(sourceAddr);
-	if (challenge.master != request.GetMasterChallenge())
+	auto challenge = m_serverList.ValidateAdminChallenge(sourceAddr, request.GetMasterChallenge());
+	if (!challenge.has_value())
 	{
 		Utils::Log("Incorrect admin challenge from {}:{}\n", sourceAddr.ToString(), sourceAddr.GetPort());
 		return;
 	}
-	m_adminCommandHandler.HandleCommandRequest(sourceAddr, request, challenge);
+	m_adminCommandHandler.HandleCommandRequest(sourceAddr, request, challenge.value());
 }
 
 void RequestHandler::SendClientQueryResponse(Socket &socket, const NetAddress &clientAddr, ClientQueryRequest &request)
 {
-	std::vector<uint8_t> buffer;
-	BinaryOutputStream stream(buffer);
-
-	auto queryKey = request.GetQueryKey();
-	ClientQueryResponse response(
-		request.ClientBypassingNat(), 
-		queryKey, 
-		request.GetProtocolVersion(), 
-		clientAddr, 
-		m_serverList.GetEntriesCollection(), 
-		request.GetGamedir());
-
-	response.Serialize(stream, m_natAnnouncedServers);
-	socket.SendTo(clientAddr, stream.GetBuffer(), stream.GetLength());
+	ServerQuery query;
+	query.family = clientAddr.GetAddressFamily();
+	query.gamedir = request.GetGamedir();
+	query.protocol = request.GetProtocolVersion();
+	query.natBypass = request.ClientBypassingNat();
+	auto result = m_serverList.Query(query, request.GetFilter());
+
+	// addresses block of cached result is sent as is, without copying it into response
+	BinaryOutputStream stream = socket.PrepareSend();
+	ClientQueryResponse response(request.GetQueryKey(), 
+		request.GetPage(), 
+		m_configManager.GetData().GetMaxResponseSize(), 
+		*result);
+
+	response.Serialize(stream);
+	socket.CommitSend(clientAddr, stream, result);
+
+	// announce client only to servers from sent page, there is no point to do it again for every page
+	if (!result->natServers.empty()) {
+		SendNatAnnouncements(socket, clientAddr, result->natServers, response.GetFirstServerIndex(), response.GetServersCount());
+	}
 }
 
 void RequestHandler::SendChallengeResponse(Socket &socket, const NetAddress &dest, uint32_t ch1, std::optional<uint32_t> ch2)
 {
-	uint8_t buffer[64];
-	BinaryOutputStream stream(buffer, sizeof(buffer));
-
+	BinaryOutputStream stream = socket.PrepareSend();
 	ServerChallengeResponse response(ch1, ch2);
 	response.Serialize(stream);
-	socket.SendTo(dest, stream.GetBuffer(), stream.GetLength());
+	socket.CommitSend(dest, stream);
 }
 
-void RequestHandler::SendFakeServerInfo(Socket &socket, const NetAddress &dest, const std::string &gamedir)
+void RequestHandler::SendFakeServerInfo(Socket &socket, const NetAddress &dest, std::string_view gamedir)
 {
-	std::vector<uint8_t> data;
-	BinaryOutputStream stream(data);
-
 	auto sendServerInfo = [&](std::string message) {
 		InfostringData infostring;
 		infostring.Insert("host", message);
@@ -238,12 +267,12 @@ void RequestHandler::SendFakeServerInfo(Socket &socket, const NetAddress &dest,
 		infostring.Insert("coop", "0");
 		infostring.Insert("numcl", "32");
 		infostring.Insert("maxcl", "32");
-		infostring.Insert("gamedir", gamedir);
+		infostring.Insert("gamedir", std::string(gamedir));
 
-		data.clear();
+		BinaryOutputStream stream = socket.PrepareSend();
 		stream.WriteString("\xff\xff\xff\xffinfo\n");
 		stream.WriteString(infostring.ToString().c_str());
-		socket.SendTo(dest, stream.GetBuffer(), stream.GetLength());
+		socket.CommitSend(dest, stream);
 	};
 
 	sendServerInfo(u8"This version is not");
@@ -256,14 +285,14 @@ void RequestHandler::SendFakeServerInfo(Socket &socket, const NetAddress &dest,
 	sendServerInfo(u8"GooglePlay или GitHub");
 }
 
-void RequestHandler::SendNatAnnouncements(Socket &socket, const NetAddress &clientAddr)
+void RequestHandler::SendNatAnnouncements(Socket &socket, const NetAddress &clientAddr, const std::vector<NetAddress> &servers, size_t first, size_t count)
 {
-	uint8_t buffer[64];
-	for (const auto &serverAddr : m_natAnnouncedServers) 
+	for (size_t i = first; i < first + count; i++) 
 	{
-		BinaryOutputStream stream(buffer, sizeof(buffer));
+		const NetAddress &serverAddr = servers[i];
+		BinaryOutputStream stream = socket.PrepareSend();
 		ServerNatAnnounce response(clientAddr);
 		response.Serialize(stream);
-		socket.SendTo(serverAddr, stream.GetBuffer(), stream.GetLength());
+		socket.CommitSend(serverAddr, stream);
 	}
 }
@@ -23,21 +23,27 @@ GNU General Public License for more details.
 #include "server_challenge_request.h"
 #include "server_append_request.h"
 #include "admin_command_request.h"
+#include "packet_dispatcher.h"
+#include "flat_hash_map.h"
 #include <vector>
 #include <optional>
-#include <unordered_set>
-#include <unordered_map>
 #include <string>
+#include <string_view>
 
 class RequestHandler
 {
 public:
 	RequestHandler(ServerList &serverList, ConfigManager &configManager);
 	void UpdateState();
-	void HandlePacket(Socket &socket, const NetAddress &sourceAddr);
+	void HandlePacket(Socket &socket, const Datagram &datagram);
+	const DispatcherStatistics &GetStatistics() const { return m_dispatcher.GetStatistics(); }
 
 private:
-	void HandleRequest(Socket &socket, const NetAddress &sourceAddr);
+	void HandleClientQuery(Socket &socket, const Datagram &datagram);
+	void HandleServerChallenge(Socket &socket, const Datagram &datagram);
+	void HandleServerAppend(Socket &socket, const Datagram &datagram);
+	void HandleAdminChallenge(Socket &socket, const Datagram &datagram);
+	void HandleAdminCommand(Socket &socket, const Datagram &datagram);
 
 	void ProcessClientQuery(Socket &socket, const NetAddress &sourceAddr, ClientQueryRequest &req);
 	void ProcessChallengeRequest(Socket &socket, const NetAddress &sourceAddr, ServerChallengeRequest &req);
@@ -47,13 +53,12 @@ private:
 
 	void SendClientQueryResponse(Socket &socket, const NetAddress &clientAddr, ClientQueryRequest &req);
 	void SendChallengeResponse(Socket &socket, const NetAddress &dest, uint32_t ch1, std::optional<uint32_t> ch2);
-	void SendFakeServerInfo(Socket &socket, const NetAddress &dest, const std::string &gamedir);
-	void SendNatAnnouncements(Socket &socket, const NetAddress &clientAddr);
+	void SendFakeServerInfo(Socket &socket, const NetAddress &dest, std::string_view gamedir);
+	void SendNatAnnouncements(Socket &socket, const NetAddress &clientAddr, const std::vector<NetAddress> &servers, size_t first, size_t count);
 
 	ServerList &m_serverList;
 	ConfigManager &m_configManager;
 	AdminCommandHandler m_adminCommandHandler;
-	std::vector<NetAddress> m_natAnnouncedServers;
-	std::unordered_set<NetAddress, NetAddressHash> m_banlist;
-	std::unordered_map<NetAddress, uint32_t, NetAddressHash> m_packetRateMap;
+	PacketDispatcher m_dispatcher;
+	FlatHashMap<NetAddress, uint32_t, NetAddressHash> m_packetRateMap;
 };
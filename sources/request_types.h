@@ -0,0 +1,57 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "client_query_request.h"
+#include "server_challenge_request.h"
+#include "server_append_request.h"
+#include "admin_challenge_request.h"
+#include "admin_command_request.h"
+#include <array>
+#include <string_view>
+#include <stdint.h>
+
+enum class RequestType : uint8_t
+{
+	ClientQuery,
+	ServerChallenge,
+	ServerAppend,
+	AdminChallenge,
+	AdminCommand,
+	Count
+};
+
+struct RequestDescriptor
+{
+	RequestType type;
+	std::string_view header;
+	std::string_view name;
+};
+
+// single list of known requests, both packet dispatcher and in-kernel packet filter are built from it
+namespace RequestTypes
+{
+	constexpr size_t Count = static_cast<size_t>(RequestType::Count);
+	constexpr std::array<RequestDescriptor, Count> Descriptors = {{
+		{ RequestType::ClientQuery, ClientQueryRequest::Header, "client query" },
+		{ RequestType::ServerChallenge, ServerChallengeRequest::Header, "server challenge" },
+		{ RequestType::ServerAppend, ServerAppendRequest::Header, "server append" },
+		{ RequestType::AdminChallenge, AdminChallengeRequest::Header, "admin challenge" },
+		{ RequestType::AdminCommand, AdminCommandRequest::Header, "admin command" },
+	}};
+
+	constexpr const RequestDescriptor& Get(RequestType type) {
+		return Descriptors[static_cast<size_t>(type)];
+	}
+}
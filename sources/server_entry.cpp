@@ -12,8 +12,8 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
 GNU General Public License for more details.
 */
 
-#include <scn/scan.h>
 #include "server_entry.h"
+#include "utils.h"
 
 ServerEntry::ServerEntry(const NetAddress &address) :
 	m_address(address),
@@ -26,29 +26,101 @@ ServerEntry::ServerEntry(const NetAddress &address) :
 	m_maxPlayers(0),
 	m_natBypass(false),
 	m_passwordUsed(false),
-	m_secured(false)
+	m_secured(false),
+	m_expirationTicket(0)
 {
 	m_keepAliveTimer.Reset();
 }
 
-void ServerEntry::Update(const InfostringData &data)
+void ServerEntry::Update(const InfostringView &data, StringPool &stringPool)
 {
-	m_protocol = scn::scan_int<uint32_t>(data["protocol"].value())->value();
-	m_players = scn::scan_int<uint32_t>(data["players"].value())->value();
-	m_maxPlayers = scn::scan_int<uint32_t>(data["max"].value())->value();
-	m_bots = scn::scan_int<uint32_t>(data["bots"].value())->value();
-	m_regionCode = scn::scan_int<uint32_t>(data["region"].value())->value();
-
-	m_gamedir = data["gamedir"].value();
-	m_mapName = data["map"].value();
-	m_version = data["version"].value();
-	m_osType = data["os"].value();
-	m_product = data["product"].value();
-	m_dedicated = data["type"].value().compare("d") ? false : true;
-	m_passwordUsed = data["password"].value().compare("0") ? true : false;
-	m_secured = data["secure"].value().compare("0") ? true : false;
-	m_lanMode = data["lan"].value().compare("0") ? true : false;
-	m_natBypass = data["nat"].value().compare("0") ? true : false;
+	m_protocol = Utils::ParseInteger<uint32_t>(data[InfostringKey::Protocol].value()).value_or(0);
+	m_players = Utils::ParseInteger<uint32_t>(data[InfostringKey::Players].value()).value_or(0);
+	m_maxPlayers = Utils::ParseInteger<uint32_t>(data[InfostringKey::Max].value()).value_or(0);
+	m_bots = Utils::ParseInteger<uint32_t>(data[InfostringKey::Bots].value()).value_or(0);
+	m_regionCode = Utils::ParseInteger<uint32_t>(data[InfostringKey::Region].value()).value_or(0);
+
+	// distinct values are just a few, so usually it's only lookup in pool without allocations
+	m_gamedir = stringPool.Intern(data[InfostringKey::Gamedir].value());
+	m_mapName = stringPool.Intern(data[InfostringKey::Map].value());
+	m_version = stringPool.Intern(data[InfostringKey::Version].value());
+	m_osType = stringPool.Intern(data[InfostringKey::Os].value());
+	m_product = stringPool.Intern(data[InfostringKey::Product].value());
+	m_dedicated = data[InfostringKey::Type].value() == "d";
+	m_passwordUsed = data[InfostringKey::Password].value() != "0";
+	m_secured = data[InfostringKey::Secure].value() != "0";
+	m_lanMode = data[InfostringKey::Lan].value() != "0";
+	m_natBypass = data[InfostringKey::Nat].value() != "0";
+}
+
+ServerEntry::SnapshotRecord ServerEntry::GetSnapshotRecord() const
+{
+	SnapshotRecord record;
+	record.protocol = m_protocol;
+	record.players = m_players;
+	record.maxPlayers = m_maxPlayers;
+	record.bots = m_bots;
+	record.regionCode = m_regionCode;
+	record.flags = (m_passwordUsed ? 1 : 0) | 
+		(m_secured ? 2 : 0) | 
+		(m_lanMode ? 4 : 0) | 
+		(m_natBypass ? 8 : 0) | 
+		(m_dedicated ? 16 : 0);
+	record.gamedir = m_gamedir.Get();
+	record.mapName = m_mapName.Get();
+	record.version = m_version.Get();
+	record.osType = m_osType.Get();
+	record.product = m_product.Get();
+	return record;
+}
+
+void ServerEntry::SnapshotRecord::Write(BinaryOutputStream &stream) const
+{
+	stream.Write<uint32_t>(protocol);
+	stream.Write<uint32_t>(players);
+	stream.Write<uint32_t>(maxPlayers);
+	stream.Write<uint32_t>(bots);
+	stream.Write<uint32_t>(regionCode);
+	stream.Write<uint8_t>(flags);
+	stream.WriteString(gamedir.c_str(), true);
+	stream.WriteString(mapName.c_str(), true);
+	stream.WriteString(version.c_str(), true);
+	stream.WriteString(osType.c_str(), true);
+	stream.WriteString(product.c_str(), true);
+}
+
+bool ServerEntry::ReadSnapshot(BinaryInputStream &stream, StringPool &stringPool)
+{
+	m_protocol = stream.Read<uint32_t>();
+	m_players = stream.Read<uint32_t>();
+	m_maxPlayers = stream.Read<uint32_t>();
+	m_bots = stream.Read<uint32_t>();
+	m_regionCode = stream.Read<uint32_t>();
+
+	const uint8_t flags = stream.Read<uint8_t>();
+	m_passwordUsed = (flags & 1) != 0;
+	m_secured = (flags & 2) != 0;
+	m_lanMode = (flags & 4) != 0;
+	m_natBypass = (flags & 8) != 0;
+	m_dedicated = (flags & 16) != 0;
+
+	// views point to mapped snapshot file, and pool copies only strings it doesn't have yet
+	std::string_view gamedir, mapName, version, osType, product;
+	stream.ReadStringView(gamedir);
+	stream.ReadStringView(mapName);
+	stream.ReadStringView(version);
+	stream.ReadStringView(osType);
+	stream.ReadStringView(product);
+	if (stream.Underflowed()) {
+		return false;
+	}
+
+	m_gamedir = stringPool.Intern(gamedir);
+	m_mapName = stringPool.Intern(mapName);
+	m_version = stringPool.Intern(version);
+	m_osType = stringPool.Intern(osType);
+	m_product = stringPool.Intern(product);
+	return true;
 }
 
 void ServerEntry::ResetTimeout()
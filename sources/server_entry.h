@@ -15,7 +15,10 @@ GNU General Public License for more details.
 #pragma once
 #include "timer.h"
 #include "net_address.h"
-#include "infostring_data.h"
+#include "infostring_view.h"
+#include "string_pool.h"
+#include "binary_input_stream.h"
+#include "binary_output_stream.h"
 #include <string>
 #include <vector>
 #include <stdint.h>
@@ -23,24 +26,53 @@ GNU General Public License for more details.
 class ServerEntry
 {
 public:
+	// plain copy of snapshot fields, it doesn't hold string pool handles so it's serialized without list lock
+	struct SnapshotRecord
+	{
+		uint32_t protocol;
+		uint32_t players;
+		uint32_t maxPlayers;
+		uint32_t bots;
+		uint32_t regionCode;
+		uint8_t flags;
+		std::string gamedir;
+		std::string mapName;
+		std::string version;
+		std::string osType;
+		std::string product;
+
+		void Write(BinaryOutputStream &stream) const;
+	};
+
 	ServerEntry(const NetAddress &address);
 	ServerEntry(const ServerEntry&) = default;
 	ServerEntry(ServerEntry&&) noexcept = default;
 	ServerEntry& operator=(ServerEntry&&) noexcept = default;
 	ServerEntry& operator=(const ServerEntry&) = default;
 
-	void Update(const InfostringData &data);
+	void Update(const InfostringView &data, StringPool &stringPool);
+	SnapshotRecord GetSnapshotRecord() const;
+	bool ReadSnapshot(BinaryInputStream &stream, StringPool &stringPool);
 	void ResetTimeout();
 	bool Expired(double interval) const;
+	int64_t GetLastUpdateTime() const { return m_keepAliveTimer.GetTimePoint(); }
+	void SetLastUpdateTime(int64_t time) { m_keepAliveTimer.SetTimePoint(time); }
+	uint64_t GetExpirationTicket() const { return m_expirationTicket; }
+	void SetExpirationTicket(uint64_t ticket) { m_expirationTicket = ticket; }
 
 	bool NatBypassEnabled() const { return m_natBypass; }
+	bool PasswordUsed() const { return m_passwordUsed; }
+	bool IsDedicated() const { return m_dedicated; }
+	uint32_t GetRegionCode() const { return m_regionCode; }
 	uint32_t GetProtocolVersion() const { return m_protocol; }
 	uint32_t GetMaxPlayers() const { return m_maxPlayers; }
 	uint32_t GetBotsCount() const { return m_bots; }
 	uint32_t GetPlayersCount() const { return m_players; }
-	const std::string &GetMapName() const { return m_mapName; }
-	const std::string &GetGamedir() const { return m_gamedir; }
-	const std::string &GetVersion() const { return m_version; }
+	const std::string &GetMapName() const { return m_mapName.Get(); }
+	const std::string &GetGamedir() const { return m_gamedir.Get(); }
+	const std::string &GetVersion() const { return m_version.Get(); }
+	const InternedString &GetInternedGamedir() const { return m_gamedir; }
+	const InternedString &GetInternedMapName() const { return m_mapName; }
 	const NetAddress &GetAddress() const { return m_address; }
 
 private:
@@ -50,16 +82,16 @@ private:
 	uint32_t m_maxPlayers;
 	uint32_t m_bots;
 	uint32_t m_regionCode;
-	std::string m_gamedir;
-	std::string m_mapName;
-	std::string m_version;
-	std::string m_serverType;
-	std::string m_osType;
-	std::string m_product;
+	InternedString m_gamedir;
+	InternedString m_mapName;
+	InternedString m_version;
+	InternedString m_osType;
+	InternedString m_product;
 	bool m_passwordUsed;
 	bool m_secured;
 	bool m_lanMode;
 	bool m_natBypass;
 	bool m_dedicated;
 	Timer m_keepAliveTimer;
+	uint64_t m_expirationTicket; // ticket of timing wheel schedule
 };
@@ -0,0 +1,56 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "server_filter.h"
+#include "utils.h"
+
+std::optional<ServerFilter> ServerFilter::Parse(const InfostringView &data)
+{
+	ServerFilter filter;
+	auto flagEnabled = [&data](InfostringKey key) {
+		auto value = data[key];
+		return value.has_value() && value.value() != "0";
+	};
+
+	filter.m_notEmpty = flagEnabled(InfostringKey::NoEmpty);
+	filter.m_notFull = flagEnabled(InfostringKey::NoFull);
+	filter.m_noPassword = flagEnabled(InfostringKey::NoPassword);
+	filter.m_dedicatedOnly = flagEnabled(InfostringKey::Dedicated);
+
+	if (data[InfostringKey::Map].has_value()) {
+		filter.m_mapName = std::string(data[InfostringKey::Map].value());
+	}
+
+	if (data[InfostringKey::Region].has_value()) 
+	{
+		auto scan = Utils::ParseInteger<uint32_t>(data[InfostringKey::Region].value());
+		if (scan.has_value()) {
+			filter.m_regionCode = scan.value();
+		}
+		else {
+			return std::nullopt; // invalid region code
+		}
+	}
+	return filter;
+}
+
+bool ServerFilter::IsEmpty() const
+{
+	return !m_notEmpty && 
+		!m_notFull && 
+		!m_noPassword && 
+		!m_dedicatedOnly && 
+		!m_mapName.has_value() && 
+		!m_regionCode.has_value();
+}
@@ -0,0 +1,42 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "infostring_view.h"
+#include <string>
+#include <optional>
+#include <stdint.h>
+
+// optional conditions from client query, which are narrowing down list of servers
+class ServerFilter
+{
+public:
+	static std::optional<ServerFilter> Parse(const InfostringView &data);
+
+	bool IsEmpty() const;
+	bool NotEmpty() const { return m_notEmpty; }
+	bool NotFull() const { return m_notFull; }
+	bool NoPassword() const { return m_noPassword; }
+	bool DedicatedOnly() const { return m_dedicatedOnly; }
+	const std::optional<std::string> &GetMapName() const { return m_mapName; }
+	std::optional<uint32_t> GetRegionCode() const { return m_regionCode; }
+
+private:
+	bool m_notEmpty = false;
+	bool m_notFull = false;
+	bool m_noPassword = false;
+	bool m_dedicatedOnly = false;
+	std::optional<std::string> m_mapName;
+	std::optional<uint32_t> m_regionCode;
+};
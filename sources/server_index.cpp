@@ -0,0 +1,57 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "server_index.h"
+#include <algorithm>
+
+void ServerIndex::Insert(const ServerEntry &entry)
+{
+	const size_t bucketIndex = GetBucketIndex(entry.GetAddress().GetAddressFamily(), entry.NatBypassEnabled());
+	m_gamedirs[entry.GetInternedGamedir().GetId()][entry.GetProtocolVersion()][bucketIndex].insert(entry.GetAddress());
+}
+
+void ServerIndex::Remove(const ServerEntry &entry)
+{
+	Remove(entry.GetAddress(), entry.GetInternedGamedir().GetId(), entry.GetProtocolVersion(), entry.NatBypassEnabled());
+}
+
+void ServerIndex::Remove(const NetAddress &address, uint32_t gamedirId, uint32_t protocol, bool natBypass)
+{
+	auto gamedirIt = m_gamedirs.find(gamedirId);
+	if (gamedirIt == m_gamedirs.end()) {
+		return;
+	}
+
+	auto protocolIt = gamedirIt->second.find(protocol);
+	if (protocolIt == gamedirIt->second.end()) {
+		return;
+	}
+
+	// remove empty buckets, otherwise mods that are gone would stay in index forever
+	ProtocolBuckets &buckets = protocolIt->second;
+	buckets[GetBucketIndex(address.GetAddressFamily(), natBypass)].erase(address);
+	if (std::all_of(buckets.begin(), buckets.end(), [](const AddressSet &set) { return set.empty(); })) 
+	{
+		gamedirIt->second.erase(protocolIt);
+		if (gamedirIt->second.empty()) {
+			m_gamedirs.erase(gamedirIt);
+		}
+	}
+}
+
+size_t ServerIndex::GetBucketIndex(NetAddress::AddressFamily family, bool natBypass)
+{
+	const size_t familyIndex = (family == NetAddress::AddressFamily::IPv6) ? 1 : 0;
+	return (natBypass ? 2 : 0) + familyIndex;
+}
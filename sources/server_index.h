@@ -0,0 +1,70 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "net_address.h"
+#include "server_entry.h"
+#include "query_cache.h"
+#include "flat_hash_map.h"
+#include <array>
+#include <unordered_map>
+#include <stdint.h>
+
+// groups servers by fields which are used in client queries, so query could visit only matching servers
+class ServerIndex
+{
+public:
+	void Insert(const ServerEntry &entry);
+	void Remove(const ServerEntry &entry);
+	void Remove(const NetAddress &address, uint32_t gamedirId, uint32_t protocol, bool natBypass);
+
+	// gamedir ID from string pool should be found for query first
+	template<class F> void ForEach(const ServerQuery &query, uint32_t gamedirId, F &&callback) const
+	{
+		auto gamedirIt = m_gamedirs.find(gamedirId);
+		if (gamedirIt == m_gamedirs.end()) {
+			return;
+		}
+
+		const size_t bucketIndex = GetBucketIndex(query.family, query.natBypass);
+		if (query.protocol.has_value())
+		{
+			auto protocolIt = gamedirIt->second.find(query.protocol.value());
+			if (protocolIt != gamedirIt->second.end()) 
+			{
+				for (const NetAddress &address : protocolIt->second[bucketIndex]) {
+					callback(address);
+				}
+			}
+		}
+		else
+		{
+			for (const auto &[protocol, buckets] : gamedirIt->second) 
+			{
+				for (const NetAddress &address : buckets[bucketIndex]) {
+					callback(address);
+				}
+			}
+		}
+	}
+
+private:
+	using AddressSet = FlatHashSet<NetAddress, NetAddressPortHash>;
+	using ProtocolBuckets = std::array<AddressSet, 4>; // indexed by NAT flag and address family
+	using GamedirBuckets = std::unordered_map<uint32_t, ProtocolBuckets>;
+
+	static size_t GetBucketIndex(NetAddress::AddressFamily family, bool natBypass);
+
+	std::unordered_map<uint32_t, GamedirBuckets> m_gamedirs;
+};
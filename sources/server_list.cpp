@@ -13,11 +13,40 @@ GNU General Public License for more details.
 */
 
 #include "server_list.h"
+#include "binary_output_stream.h"
 #include <event2/util.h>
 #include <algorithm>
 
+// one second resolution is enough for timeouts, and wheel span covers default server timeout.
+// longer deadlines are just staying in slot for several rounds of wheel
+static constexpr size_t ExpirationSlotsCount = 512;
+static constexpr int64_t ExpirationResolution = Clock::TicksPerSecond;
+
+static void WriteSnapshotAddress(BinaryOutputStream &stream, const NetAddress &address)
+{
+	stream.Write<uint8_t>(address.GetAddressFamily() == NetAddress::AddressFamily::IPv4 ? 4 : 6);
+	stream.WriteNetAddress(address);
+}
+
+static std::optional<NetAddress> ReadSnapshotAddress(BinaryInputStream &stream)
+{
+	const uint8_t family = stream.Read<uint8_t>();
+	if (family != 4 && family != 6) {
+		return std::nullopt;
+	}
+	return stream.ReadNetAddress(family == 4 ? NetAddress::AddressFamily::IPv4 : NetAddress::AddressFamily::IPv6);
+}
+
+static uint32_t GetSnapshotAge(int64_t currentTime, int64_t timePoint)
+{
+	return static_cast<uint32_t>(std::clamp<int64_t>(currentTime - timePoint, 0, UINT32_MAX));
+}
+
 ServerList::ServerList(ConfigManager &configManager) : 
-	m_configManager(configManager)
+	m_configManager(configManager),
+	m_serverExpirations(ExpirationSlotsCount, ExpirationResolution, Clock::GetTicks()),
+	m_challengeExpirations(ExpirationSlotsCount, ExpirationResolution, Clock::GetTicks()),
+	m_adminChallengeExpirations(ExpirationSlotsCount, ExpirationResolution, Clock::GetTicks())
 {
 }
 
@@ -32,12 +61,48 @@ ServerEntry &ServerList::Insert(const NetAddress &address)
 {
 	if (m_serverCountMap.count(address) < 1)
 	{
-		m_serversMap.insert({ address, std::move(ServerEntry(address)) });
+		auto [it, inserted] = m_serversMap.insert({ address, std::move(ServerEntry(address)) });
 		m_serverCountMap[address] += 1;
+		if (inserted)
+		{
+			// heartbeats don't touch wheel, actual deadline is checked when this one is fired
+			const int64_t deadline = it->second.GetLastUpdateTime() + Clock::SecondsToTicks(m_configManager.GetData().GetServerTimeoutInterval());
+			it->second.SetExpirationTicket(m_serverExpirations.Schedule(address, deadline));
+		}
 	}
 	return m_serversMap.at(address);
 }
 
+ServerEntry &ServerList::Update(const NetAddress &address, const InfostringView &data)
+{
+	const bool serverExists = Contains(address);
+	ServerEntry &entry = Insert(address);
+	const InternedString oldGamedir = entry.GetInternedGamedir();
+	const uint32_t oldProtocol = entry.GetProtocolVersion();
+	const bool oldNatBypass = entry.NatBypassEnabled();
+
+	entry.Update(data, m_stringPool);
+	entry.ResetTimeout();
+	m_serverTable.Update(entry); // players count could be changed with any update
+
+	// usually it's just heartbeat without changes, so cached queries are still valid
+	const bool queryFieldsChanged = oldGamedir != entry.GetInternedGamedir() || 
+		oldProtocol != entry.GetProtocolVersion() || 
+		oldNatBypass != entry.NatBypassEnabled();
+
+	if (!serverExists || queryFieldsChanged) 
+	{
+		if (serverExists) 
+		{
+			m_serverIndex.Remove(address, oldGamedir.GetId(), oldProtocol, oldNatBypass);
+			m_queryCache.Invalidate(address.GetAddressFamily(), oldGamedir.Get());
+		}
+		m_serverIndex.Insert(entry);
+		InvalidateQueries(entry);
+	}
+	return entry;
+}
+
 bool ServerList::Contains(const NetAddress &addr) const
 {
 	return m_serversMap.count(addr) > 0;
@@ -45,12 +110,17 @@ bool ServerList::Contains(const NetAddress &addr) const
 
 void ServerList::BanAddress(const NetAddress &address)
 {
+	m_banlist.insert(address);
 	m_serverCountMap.erase(address);
 	for (auto it = m_serversMap.begin(); it != m_serversMap.end();)
 	{
 		const auto &entry = it->second;
 		const auto serverAddress = it->first;
-		if (serverAddress.Equals(address)) {
+		if (serverAddress.Equals(address)) 
+		{
+			InvalidateQueries(entry);
+			m_serverIndex.Remove(entry);
+			m_serverTable.Remove(serverAddress);
 			it = m_serversMap.erase(it);
 		}
 		else {
@@ -59,13 +129,34 @@ void ServerList::BanAddress(const NetAddress &address)
 	}
 }
 
+void ServerList::UnbanAddress(const NetAddress &address)
+{
+	m_banlist.erase(address);
+}
+
+bool ServerList::IsBanned(const NetAddress &address) const
+{
+	return m_banlist.count(address) > 0;
+}
+
+bool ServerList::StatelessChallengesEnabled() const
+{
+	return m_configManager.GetData().GetStatelessChallenges();
+}
+
 uint32_t ServerList::GenerateChallenge(const NetAddress &address)
 {
+	if (StatelessChallengesEnabled()) {
+		return m_challengeGenerator.GenerateServerChallenge(address, Clock::SecondsToTicks(m_configManager.GetData().GetChallengeTimeoutInterval()));
+	}
+
 	if (m_challengeMap.count(address) < 1)
 	{
 		uint32_t challenge;
 		evutil_secure_rng_get_bytes(&challenge, sizeof(challenge));
-		m_challengeMap.insert({ address, Expirable<uint32_t>(challenge) });
+		auto [it, inserted] = m_challengeMap.insert({ address, Expirable<uint32_t>(challenge) });
+		const int64_t deadline = it->second.GetCreationTime() + Clock::SecondsToTicks(m_configManager.GetData().GetChallengeTimeoutInterval());
+		it->second.SetExpirationTicket(m_challengeExpirations.Schedule(address, deadline));
 	}
 	return m_challengeMap.at(address).GetValue();
 }
@@ -75,8 +166,11 @@ bool ServerList::CheckForChallenge(const NetAddress &address) const
 	return m_challengeMap.count(address) > 0;
 }
 
-bool ServerList::ValidateChallenge(const NetAddress &address, uint32_t challenge) const
+bool ServerList::ValidateChallenge(const NetAddress &address, uint32_t challenge)
 {
+	if (StatelessChallengesEnabled()) {
+		return m_challengeGenerator.ValidateServerChallenge(address, challenge, Clock::SecondsToTicks(m_configManager.GetData().GetChallengeTimeoutInterval()));
+	}
 	if (m_challengeMap.count(address) < 1) {
 		return false;
 	}
@@ -85,12 +179,18 @@ bool ServerList::ValidateChallenge(const NetAddress &address, uint32_t challenge
 
 AdminChallenge ServerList::GetAdminChallenge(const NetAddress &address)
 {
+	if (StatelessChallengesEnabled()) {
+		return m_challengeGenerator.GenerateAdminChallenge(address, Clock::SecondsToTicks(m_configManager.GetData().GetChallengeTimeoutInterval()));
+	}
+
 	if (m_adminChallengeMap.count(address) < 1)
 	{
 		AdminChallenge challenge;
 		evutil_secure_rng_get_bytes(&challenge.hash, sizeof(challenge.hash));
 		evutil_secure_rng_get_bytes(&challenge.master, sizeof(challenge.master));
-		m_adminChallengeMap.insert({ address, Expirable<AdminChallenge>(challenge) });
+		auto [it, inserted] = m_adminChallengeMap.insert({ address, Expirable<AdminChallenge>(challenge) });
+		const int64_t deadline = it->second.GetCreationTime() + Clock::SecondsToTicks(m_configManager.GetData().GetChallengeTimeoutInterval());
+		it->second.SetExpirationTicket(m_adminChallengeExpirations.Schedule(address, deadline));
 	}
 	return m_adminChallengeMap.at(address).GetValue();
 }
@@ -100,13 +200,297 @@ bool ServerList::CheckAdminChallenge(const NetAddress &address) const
 	return m_adminChallengeMap.count(address) > 0;
 }
 
+std::optional<AdminChallenge> ServerList::ValidateAdminChallenge(const NetAddress &address, uint32_t master)
+{
+	if (StatelessChallengesEnabled()) {
+		return m_challengeGenerator.ValidateAdminChallenge(address, master, Clock::SecondsToTicks(m_configManager.GetData().GetChallengeTimeoutInterval()));
+	}
+
+	auto it = m_adminChallengeMap.find(address);
+	if (it == m_adminChallengeMap.end() || it->second.GetValue().master != master) {
+		return std::nullopt;
+	}
+	return it->second.GetValue();
+}
+
 size_t ServerList::GetCountForAddress(const NetAddress &addr) const
 {
 	return (m_serverCountMap.count(addr) < 1) ? 0 : m_serverCountMap.at(addr);
 }
 
+std::shared_ptr<const ServerQueryResult> ServerList::Query(const ServerQuery &query, const ServerFilter &filter) const
+{
+	// filters are depending on fields which are changed with every heartbeat, 
+	// so such results are not cached
+	if (!filter.IsEmpty()) {
+		return BuildFilteredQueryResult(query, filter);
+	}
+
+	auto cachedResult = m_queryCache.Find(query);
+	if (cachedResult) {
+		return cachedResult;
+	}
+
+	auto result = BuildQueryResult(query);
+	m_queryCache.Store(query, result);
+	return result;
+}
+
+std::shared_ptr<ServerQueryResult> ServerList::BuildQueryResult(const ServerQuery &query) const
+{
+	auto result = std::make_shared<ServerQueryResult>();
+	result->addressSize = (query.family == NetAddress::AddressFamily::IPv4) ? 6 : 18;
+	auto gamedirId = m_stringPool.FindId(query.gamedir);
+	if (!gamedirId.has_value()) {
+		return result; // there is no servers with such gamedir at all
+	}
+
+	BinaryOutputStream stream(result->addresses);
+	m_serverIndex.ForEach(query, gamedirId.value(), [&](const NetAddress &serverAddr) {
+		if (query.natBypass) {
+			result->natServers.push_back(serverAddr);
+		}
+		stream.WriteNetAddress(serverAddr);
+	});
+	return result;
+}
+
+std::shared_ptr<ServerQueryResult> ServerList::BuildFilteredQueryResult(const ServerQuery &query, const ServerFilter &filter) const
+{
+	auto result = std::make_shared<ServerQueryResult>();
+	result->addressSize = (query.family == NetAddress::AddressFamily::IPv4) ? 6 : 18;
+	auto gamedirId = m_stringPool.FindId(query.gamedir);
+	if (!gamedirId.has_value()) {
+		return result;
+	}
+
+	std::optional<uint32_t> mapId;
+	if (filter.GetMapName().has_value()) 
+	{
+		mapId = m_stringPool.FindId(filter.GetMapName().value());
+		if (!mapId.has_value()) {
+			return result; // nobody plays on such map
+		}
+	}
+
+	// strings are compared by their IDs in pool, so every condition is checked for whole table with SIMD
+	thread_local std::vector<uint32_t> rows;
+	auto predicate = ServerTable::MakePredicate(query, filter, gamedirId.value(), mapId);
+	m_serverTable.Select(predicate, rows);
+	result->addresses.reserve(rows.size() * result->addressSize);
+	for (uint32_t row : rows)
+	{
+		const NetAddress &serverAddr = m_serverTable.GetAddress(row);
+		if (query.natBypass) {
+			result->natServers.push_back(serverAddr);
+		}
+		const uint8_t *wireAddress = m_serverTable.GetWireAddress(row);
+		result->addresses.insert(result->addresses.end(), wireAddress, wireAddress + result->addressSize);
+	}
+	return result;
+}
+
+ServerListSnapshot ServerList::TakeSnapshot() const
+{
+	// only age of records is kept, since monotonic clock is not valid after restart
+	const int64_t currentTime = Clock::GetTicks();
+	ServerListSnapshot snapshot;
+	snapshot.servers.reserve(m_serversMap.size());
+	for (const auto &[address, entry] : m_serversMap) {
+		snapshot.servers.push_back({ address, GetSnapshotAge(currentTime, entry.GetLastUpdateTime()), entry.GetSnapshotRecord() });
+	}
+
+	snapshot.challenges.reserve(m_challengeMap.size());
+	for (const auto &[address, challenge] : m_challengeMap) {
+		snapshot.challenges.push_back({ address, GetSnapshotAge(currentTime, challenge.GetCreationTime()), challenge.GetValue() });
+	}
+
+	snapshot.adminChallenges.reserve(m_adminChallengeMap.size());
+	for (const auto &[address, challenge] : m_adminChallengeMap) {
+		snapshot.adminChallenges.push_back({ address, GetSnapshotAge(currentTime, challenge.GetCreationTime()), challenge.GetValue() });
+	}
+
+	snapshot.banlist.reserve(m_banlist.size());
+	for (const NetAddress &address : m_banlist) {
+		snapshot.banlist.push_back(address);
+	}
+	return snapshot;
+}
+
+void ServerListSnapshot::Write(BinaryOutputStream &stream) const
+{
+	stream.Write<uint32_t>(static_cast<uint32_t>(servers.size()));
+	for (const ServerRecord &record : servers) 
+	{
+		WriteSnapshotAddress(stream, record.address);
+		stream.Write<uint32_t>(record.age);
+		record.entry.Write(stream);
+	}
+
+	stream.Write<uint32_t>(static_cast<uint32_t>(challenges.size()));
+	for (const ChallengeRecord &record : challenges) 
+	{
+		WriteSnapshotAddress(stream, record.address);
+		stream.Write<uint32_t>(record.age);
+		stream.Write<uint32_t>(record.value);
+	}
+
+	stream.Write<uint32_t>(static_cast<uint32_t>(adminChallenges.size()));
+	for (const AdminChallengeRecord &record : adminChallenges) 
+	{
+		WriteSnapshotAddress(stream, record.address);
+		stream.Write<uint32_t>(record.age);
+		stream.Write<uint32_t>(record.value.master);
+		stream.Write<uint32_t>(record.value.hash);
+	}
+
+	stream.Write<uint32_t>(static_cast<uint32_t>(banlist.size()));
+	for (const NetAddress &address : banlist) {
+		WriteSnapshotAddress(stream, address);
+	}
+}
+
+bool ServerList::ReadSnapshot(BinaryInputStream &stream, int64_t downtime)
+{
+	const int64_t currentTime = Clock::GetTicks();
+	const int64_t serverTimeout = Clock::SecondsToTicks(m_configManager.GetData().GetServerTimeoutInterval());
+	const int64_t challengeTimeout = Clock::SecondsToTicks(m_configManager.GetData().GetChallengeTimeoutInterval());
+
+	// every section is parsed into temporary lists first, and list is modified only 
+	// when whole stream is valid, so corrupted snapshot doesn't leave it half-restored
+	const uint32_t serversCount = stream.Read<uint32_t>();
+	std::vector<ServerEntry> servers;
+	for (uint32_t i = 0; i < serversCount; i++)
+	{
+		auto address = ReadSnapshotAddress(stream);
+		const int64_t lastUpdateTime = currentTime - stream.Read<uint32_t>() - downtime;
+		if (!address.has_value()) {
+			return false;
+		}
+
+		ServerEntry entry(address.value());
+		if (!entry.ReadSnapshot(stream, m_stringPool)) {
+			return false;
+		}
+		if (lastUpdateTime + serverTimeout >= currentTime) 
+		{
+			entry.SetLastUpdateTime(lastUpdateTime);
+			servers.push_back(std::move(entry));
+		}
+	}
+
+	const uint32_t challengesCount = stream.Read<uint32_t>();
+	std::vector<std::pair<NetAddress, Expirable<uint32_t>>> challenges;
+	for (uint32_t i = 0; i < challengesCount; i++)
+	{
+		auto address = ReadSnapshotAddress(stream);
+		const int64_t creationTime = currentTime - stream.Read<uint32_t>() - downtime;
+		const uint32_t value = stream.Read<uint32_t>();
+		if (!address.has_value() || stream.Underflowed()) {
+			return false;
+		}
+		if (creationTime + challengeTimeout >= currentTime) 
+		{
+			challenges.push_back({ address.value(), Expirable<uint32_t>(value) });
+			challenges.back().second.SetCreationTime(creationTime);
+		}
+	}
+
+	const uint32_t adminChallengesCount = stream.Read<uint32_t>();
+	std::vector<std::pair<NetAddress, Expirable<AdminChallenge>>> adminChallenges;
+	for (uint32_t i = 0; i < adminChallengesCount; i++)
+	{
+		auto address = ReadSnapshotAddress(stream);
+		const int64_t creationTime = currentTime - stream.Read<uint32_t>() - downtime;
+		AdminChallenge challenge;
+		challenge.master = stream.Read<uint32_t>();
+		challenge.hash = stream.Read<uint32_t>();
+		if (!address.has_value() || stream.Underflowed()) {
+			return false;
+		}
+		if (creationTime + challengeTimeout >= currentTime) 
+		{
+			adminChallenges.push_back({ address.value(), Expirable<AdminChallenge>(challenge) });
+			adminChallenges.back().second.SetCreationTime(creationTime);
+		}
+	}
+
+	const uint32_t bannedCount = stream.Read<uint32_t>();
+	std::vector<NetAddress> banlist;
+	for (uint32_t i = 0; i < bannedCount; i++)
+	{
+		auto address = ReadSnapshotAddress(stream);
+		if (!address.has_value()) {
+			return false;
+		}
+		banlist.push_back(address.value());
+	}
+
+	if (stream.Underflowed()) {
+		return false;
+	}
+
+	for (const NetAddress &address : banlist) {
+		m_banlist.insert(address);
+	}
+
+	for (auto &[address, challenge] : challenges)
+	{
+		if (m_challengeMap.count(address) < 1) 
+		{
+			const int64_t deadline = challenge.GetCreationTime() + challengeTimeout;
+			auto [it, inserted] = m_challengeMap.insert({ address, challenge });
+			it->second.SetExpirationTicket(m_challengeExpirations.Schedule(address, deadline));
+		}
+	}
+
+	for (auto &[address, challenge] : adminChallenges)
+	{
+		if (m_adminChallengeMap.count(address) < 1) 
+		{
+			const int64_t deadline = challenge.GetCreationTime() + challengeTimeout;
+			auto [it, inserted] = m_adminChallengeMap.insert({ address, challenge });
+			it->second.SetExpirationTicket(m_adminChallengeExpirations.Schedule(address, deadline));
+		}
+	}
+
+	// banlist is applied before servers to skip banned ones
+	for (ServerEntry &entry : servers) 
+	{
+		if (!IsBanned(entry.GetAddress()) && !Contains(entry.GetAddress())) {
+			Restore(std::move(entry));
+		}
+	}
+	return true;
+}
+
+void ServerList::Restore(ServerEntry &&entry)
+{
+	const NetAddress address = entry.GetAddress();
+	const int64_t deadline = entry.GetLastUpdateTime() + Clock::SecondsToTicks(m_configManager.GetData().GetServerTimeoutInterval());
+	auto [it, inserted] = m_serversMap.insert({ address, std::move(entry) });
+	m_serverCountMap[address] += 1;
+	it->second.SetExpirationTicket(m_serverExpirations.Schedule(address, deadline));
+	m_serverTable.Update(it->second);
+	m_serverIndex.Insert(it->second);
+	InvalidateQueries(it->second);
+}
+
+void ServerList::InvalidateQueries(const ServerEntry &entry)
+{
+	m_queryCache.Invalidate(entry.GetAddress().GetAddressFamily(), entry.GetGamedir());
+}
+
 void ServerList::Remove(const NetAddress &address)
 {
+	auto it = m_serversMap.find(address);
+	if (it != m_serversMap.end()) 
+	{
+		InvalidateQueries(it->second);
+		m_serverIndex.Remove(it->second);
+		m_serverTable.Remove(address);
+	}
+
 	m_serverCountMap[address] -= 1;
 	if (m_serverCountMap[address] == 0) {
 		m_serverCountMap.erase(address);
@@ -117,46 +501,62 @@ void ServerList::Remove(const NetAddress &address)
 
 void ServerList::RemoveExpiredServers()
 {
-	for (auto it = m_serversMap.begin(); it != m_serversMap.end();)
-	{
-		const auto &entry = it->second;
-		if (entry.Expired(m_configManager.GetData().GetServerTimeoutInterval())) 
-		{
-			auto address = it->first;
-			it = m_serversMap.erase(it); 
+	const int64_t currentTime = Clock::GetTicks();
+	const int64_t timeout = Clock::SecondsToTicks(m_configManager.GetData().GetServerTimeoutInterval());
+	m_serverExpirations.Advance(currentTime, [&](const NetAddress &address, uint64_t ticket) {
+		auto it = m_serversMap.find(address);
+		if (it == m_serversMap.end() || it->second.GetExpirationTicket() != ticket) {
+			return; // server was removed before, this schedule is outdated
+		}
+
+		ServerEntry &entry = it->second;
+		const int64_t deadline = entry.GetLastUpdateTime() + timeout;
+		if (currentTime > deadline) {
 			Remove(address);
 		}
 		else {
-			it++;
+			// server sent heartbeat since it was scheduled, so move it to actual deadline
+			entry.SetExpirationTicket(m_serverExpirations.Schedule(address, deadline));
 		}
-	}
-	// TODO operations to clean up memory that was used for removed elements
+	});
 }
 
 void ServerList::RemoveExpiredChallenges()
 {
-	for (auto it = m_challengeMap.begin(); it != m_challengeMap.end();)
-	{
-		const auto &entry = it->second;
-		if (entry.Expired(m_configManager.GetData().GetChallengeTimeoutInterval())) {
-			it = m_challengeMap.erase(it);
+	const int64_t currentTime = Clock::GetTicks();
+	const int64_t timeout = Clock::SecondsToTicks(m_configManager.GetData().GetChallengeTimeoutInterval());
+	m_challengeExpirations.Advance(currentTime, [&](const NetAddress &address, uint64_t ticket) {
+		auto it = m_challengeMap.find(address);
+		if (it == m_challengeMap.end() || it->second.GetExpirationTicket() != ticket) {
+			return;
+		}
+
+		const int64_t deadline = it->second.GetCreationTime() + timeout;
+		if (currentTime > deadline) {
+			m_challengeMap.erase(it);
 		}
 		else {
-			it++;
+			it->second.SetExpirationTicket(m_challengeExpirations.Schedule(address, deadline));
 		}
-	}
+	});
 }
 
 void ServerList::RemoveExpiredAdminChallenges()
 {
-	for (auto it = m_adminChallengeMap.begin(); it != m_adminChallengeMap.end();)
-	{
-		const auto &entry = it->second;
-		if (entry.Expired(m_configManager.GetData().GetChallengeTimeoutInterval())) {
-			it = m_adminChallengeMap.erase(it);
+	const int64_t currentTime = Clock::GetTicks();
+	const int64_t timeout = Clock::SecondsToTicks(m_configManager.GetData().GetChallengeTimeoutInterval());
+	m_adminChallengeExpirations.Advance(currentTime, [&](const NetAddress &address, uint64_t ticket) {
+		auto it = m_adminChallengeMap.find(address);
+		if (it == m_adminChallengeMap.end() || it->second.GetExpirationTicket() != ticket) {
+			return;
+		}
+
+		const int64_t deadline = it->second.GetCreationTime() + timeout;
+		if (currentTime > deadline) {
+			m_adminChallengeMap.erase(it);
 		}
 		else {
-			it++;
+			it->second.SetExpirationTicket(m_adminChallengeExpirations.Schedule(address, deadline));
 		}
-	}
+	});
 }
@@ -18,41 +18,115 @@ GNU General Public License for more details.
 #include "server_entry.h"
 #include "config_manager.h"
 #include "admin_challenge.h"
+#include "query_cache.h"
+#include "server_index.h"
+#include "server_filter.h"
+#include "server_table.h"
+#include "string_pool.h"
+#include "timing_wheel.h"
+#include "challenge_generator.h"
+#include "flat_hash_map.h"
+#include "infostring_view.h"
+#include "binary_input_stream.h"
+#include "binary_output_stream.h"
 #include <string>
 #include <vector>
-#include <unordered_map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
 #include <stdint.h>
 
+// copy of list state taken under list lock, so it could be serialized later without holding it
+struct ServerListSnapshot
+{
+	struct ServerRecord
+	{
+		NetAddress address;
+		uint32_t age;
+		ServerEntry::SnapshotRecord entry;
+	};
+
+	struct ChallengeRecord
+	{
+		NetAddress address;
+		uint32_t age;
+		uint32_t value;
+	};
+
+	struct AdminChallengeRecord
+	{
+		NetAddress address;
+		uint32_t age;
+		AdminChallenge value;
+	};
+
+	void Write(BinaryOutputStream &stream) const;
+
+	std::vector<ServerRecord> servers;
+	std::vector<ChallengeRecord> challenges;
+	std::vector<AdminChallengeRecord> adminChallenges;
+	std::vector<NetAddress> banlist;
+};
+
 class ServerList
 {
 public:
-	using EntryContainer = std::unordered_map<NetAddress, ServerEntry, NetAddressPortHash>;
+	using EntryContainer = FlatHashMap<NetAddress, ServerEntry, NetAddressPortHash>;
 
 	ServerList(ConfigManager &configManager);
 	void UpdateState();
-	ServerEntry &Insert(const NetAddress &address);
+	ServerEntry &Update(const NetAddress &address, const InfostringView &data);
 	bool Contains(const NetAddress &address) const;
 	void BanAddress(const NetAddress &address);
+	void UnbanAddress(const NetAddress &address);
+	bool IsBanned(const NetAddress &address) const;
 
+	// in stateless mode challenges are not stored, so there is nothing to check before validation
+	bool StatelessChallengesEnabled() const;
 	uint32_t GenerateChallenge(const NetAddress &address);
 	bool CheckForChallenge(const NetAddress &address) const;
-	bool ValidateChallenge(const NetAddress &address, uint32_t challenge) const;
+	bool ValidateChallenge(const NetAddress &address, uint32_t challenge);
 
 	AdminChallenge GetAdminChallenge(const NetAddress &address);
 	bool CheckAdminChallenge(const NetAddress &address) const;
+	std::optional<AdminChallenge> ValidateAdminChallenge(const NetAddress &address, uint32_t master);
 
 	size_t GetCountForAddress(const NetAddress &addr) const;
+	std::shared_ptr<const ServerQueryResult> Query(const ServerQuery &query, const ServerFilter &filter) const;
 	const EntryContainer &GetEntriesCollection() const { return m_serversMap; }
 
+	ServerListSnapshot TakeSnapshot() const; // copies entries, caller should hold at least shared lock
+	// downtime is time passed since snapshot was written, it's added to age of every record.
+	// snapshot is read atomically: if stream is corrupted, nothing is restored
+	bool ReadSnapshot(BinaryInputStream &stream, int64_t downtime);
+
+	// list could be shared between several event loops, so every access should be done under this lock
+	std::shared_mutex &GetMutex() const { return m_mutex; }
+
 private:
+	ServerEntry &Insert(const NetAddress &address);
+	void Restore(ServerEntry &&entry);
 	void Remove(const NetAddress &address);
+	void InvalidateQueries(const ServerEntry &entry);
+	std::shared_ptr<ServerQueryResult> BuildQueryResult(const ServerQuery &query) const;
+	std::shared_ptr<ServerQueryResult> BuildFilteredQueryResult(const ServerQuery &query, const ServerFilter &filter) const;
 	void RemoveExpiredServers();
 	void RemoveExpiredChallenges();
 	void RemoveExpiredAdminChallenges();
 
 	ConfigManager &m_configManager;
+	mutable std::shared_mutex m_mutex;
+	StringPool m_stringPool; // should outlive entries, they're holding handles to its strings
 	EntryContainer m_serversMap;
-	std::unordered_map<NetAddress, int32_t, NetAddressHash> m_serverCountMap;
-	std::unordered_map<NetAddress, Expirable<uint32_t>, NetAddressPortHash> m_challengeMap;
-	std::unordered_map<NetAddress, Expirable<AdminChallenge>, NetAddressPortHash> m_adminChallengeMap;
+	ServerIndex m_serverIndex;
+	ServerTable m_serverTable;
+	mutable QueryCache m_queryCache;
+	FlatHashSet<NetAddress, NetAddressHash> m_banlist;
+	FlatHashMap<NetAddress, int32_t, NetAddressHash> m_serverCountMap;
+	FlatHashMap<NetAddress, Expirable<uint32_t>, NetAddressPortHash> m_challengeMap;
+	FlatHashMap<NetAddress, Expirable<AdminChallenge>, NetAddressPortHash> m_adminChallengeMap;
+	ChallengeGenerator m_challengeGenerator;
+	TimingWheel<NetAddress> m_serverExpirations;
+	TimingWheel<NetAddress> m_challengeExpirations;
+	TimingWheel<NetAddress> m_adminChallengeExpirations;
 };
@@ -0,0 +1,263 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "server_table.h"
+#include "cpu_features.h"
+#include <cstring>
+
+#if CPU_X86 == 1
+#include <immintrin.h>
+#endif
+
+void ServerTable::Update(const ServerEntry &entry)
+{
+	const NetAddress &address = entry.GetAddress();
+	auto it = m_rows.find(address);
+	if (it != m_rows.end()) 
+	{
+		WriteRow(it->second, entry);
+		return;
+	}
+
+	const size_t row = m_addresses.size();
+	m_gamedirs.push_back(0);
+	m_maps.push_back(0);
+	m_protocols.push_back(0);
+	m_flags.push_back(0);
+	m_players.push_back(0);
+	m_maxPlayers.push_back(0);
+	m_regions.push_back(0);
+	m_wireAddresses.resize(m_wireAddresses.size() + WireAddressStride);
+	m_addresses.push_back(address);
+	m_rows.insert({ address, row });
+	WriteRow(row, entry);
+}
+
+void ServerTable::Remove(const NetAddress &address)
+{
+	auto it = m_rows.find(address);
+	if (it == m_rows.end()) {
+		return;
+	}
+
+	// move last row in place of removed one, so columns are kept without gaps
+	const size_t row = it->second;
+	const size_t lastRow = m_addresses.size() - 1;
+	m_rows.erase(it);
+	if (row != lastRow)
+	{
+		m_gamedirs[row] = m_gamedirs[lastRow];
+		m_maps[row] = m_maps[lastRow];
+		m_protocols[row] = m_protocols[lastRow];
+		m_flags[row] = m_flags[lastRow];
+		m_players[row] = m_players[lastRow];
+		m_maxPlayers[row] = m_maxPlayers[lastRow];
+		m_regions[row] = m_regions[lastRow];
+		std::memcpy(&m_wireAddresses[row * WireAddressStride], &m_wireAddresses[lastRow * WireAddressStride], WireAddressStride);
+		m_addresses[row] = m_addresses[lastRow];
+		m_rows[m_addresses[row]] = row;
+	}
+
+	m_gamedirs.pop_back();
+	m_maps.pop_back();
+	m_protocols.pop_back();
+	m_flags.pop_back();
+	m_players.pop_back();
+	m_maxPlayers.pop_back();
+	m_regions.pop_back();
+	m_wireAddresses.resize(m_wireAddresses.size() - WireAddressStride);
+	m_addresses.pop_back();
+}
+
+ServerTable::Predicate ServerTable::MakePredicate(const ServerQuery &query, 
+	const ServerFilter &filter, 
+	uint32_t gamedirId, 
+	std::optional<uint32_t> mapId)
+{
+	Predicate predicate;
+	predicate.gamedirId = gamedirId;
+	predicate.mapMask = mapId.has_value() ? 0xFFFFFFFF : 0;
+	predicate.mapValue = mapId.value_or(0);
+	predicate.protocolMask = query.protocol.has_value() ? 0xFFFFFFFF : 0;
+	predicate.protocolValue = query.protocol.value_or(0);
+	predicate.flagsMask = FlagIPv6 | FlagNatBypass;
+	predicate.flagsValue = (query.family == NetAddress::AddressFamily::IPv6) ? static_cast<uint32_t>(FlagIPv6) : 0u;
+	predicate.flagsValue |= query.natBypass ? static_cast<uint32_t>(FlagNatBypass) : 0u;
+	predicate.regionMask = filter.GetRegionCode().has_value() ? 0xFFFFFFFF : 0;
+	predicate.regionValue = filter.GetRegionCode().value_or(0);
+	predicate.notEmpty = filter.NotEmpty();
+	predicate.notFull = filter.NotFull();
+
+	if (filter.NoPassword()) {
+		predicate.flagsMask |= FlagPassword;
+	}
+	if (filter.DedicatedOnly()) 
+	{
+		predicate.flagsMask |= FlagDedicated;
+		predicate.flagsValue |= FlagDedicated;
+	}
+	return predicate;
+}
+
+void ServerTable::Select(const Predicate &predicate, std::vector<uint32_t> &rows) const
+{
+	rows.clear();
+	size_t first = 0;
+#if CPU_X86 == 1
+	if (CpuFeatures::HasAvx2()) {
+		first = SelectAvx2(predicate, first, rows);
+	}
+#endif
+#if CPU_SSE2 == 1
+	first = SelectSse2(predicate, first, rows);
+#endif
+	SelectScalar(predicate, first, rows); // remaining rows that don't fill whole vector
+}
+
+void ServerTable::WriteRow(size_t row, const ServerEntry &entry)
+{
+	const NetAddress &address = entry.GetAddress();
+	uint32_t flags = 0;
+	flags |= (address.GetAddressFamily() == NetAddress::AddressFamily::IPv6) ? static_cast<uint32_t>(FlagIPv6) : 0u;
+	flags |= entry.NatBypassEnabled() ? static_cast<uint32_t>(FlagNatBypass) : 0u;
+	flags |= entry.PasswordUsed() ? static_cast<uint32_t>(FlagPassword) : 0u;
+	flags |= entry.IsDedicated() ? static_cast<uint32_t>(FlagDedicated) : 0u;
+
+	m_gamedirs[row] = entry.GetInternedGamedir().GetId();
+	m_maps[row] = entry.GetInternedMapName().GetId();
+	m_protocols[row] = entry.GetProtocolVersion();
+	m_flags[row] = flags;
+	m_players[row] = entry.GetPlayersCount();
+	m_maxPlayers[row] = entry.GetMaxPlayers();
+	m_regions[row] = entry.GetRegionCode();
+
+	// same format as in BinaryOutputStream::WriteNetAddress
+	auto [addressData, addressLength] = address.GetAddressSpan();
+	uint8_t *wireAddress = &m_wireAddresses[row * WireAddressStride];
+	std::memcpy(wireAddress, addressData, addressLength);
+	wireAddress[addressLength] = (address.GetPort() >> 8) & 0xFF;
+	wireAddress[addressLength + 1] = address.GetPort() & 0xFF;
+}
+
+size_t ServerTable::SelectScalar(const Predicate &predicate, size_t first, std::vector<uint32_t> &rows) const
+{
+	const size_t count = m_addresses.size();
+	for (size_t i = first; i < count; i++)
+	{
+		bool match = m_gamedirs[i] == predicate.gamedirId;
+		match &= (m_maps[i] & predicate.mapMask) == predicate.mapValue;
+		match &= (m_protocols[i] & predicate.protocolMask) == predicate.protocolValue;
+		match &= (m_flags[i] & predicate.flagsMask) == predicate.flagsValue;
+		match &= (m_regions[i] & predicate.regionMask) == predicate.regionValue;
+		// signed comparison, same as vectorized versions do
+		match &= !predicate.notEmpty || static_cast<int32_t>(m_players[i]) > 0;
+		match &= !predicate.notFull || static_cast<int32_t>(m_players[i]) < static_cast<int32_t>(m_maxPlayers[i]);
+		if (match) {
+			rows.push_back(i);
+		}
+	}
+	return count;
+}
+
+size_t ServerTable::SelectSse2(const Predicate &predicate, size_t first, std::vector<uint32_t> &rows) const
+{
+#if CPU_SSE2 == 1
+	const size_t count = m_addresses.size();
+	const __m128i gamedirId = _mm_set1_epi32(predicate.gamedirId);
+	const __m128i mapMask = _mm_set1_epi32(predicate.mapMask);
+	const __m128i mapValue = _mm_set1_epi32(predicate.mapValue);
+	const __m128i protocolMask = _mm_set1_epi32(predicate.protocolMask);
+	const __m128i protocolValue = _mm_set1_epi32(predicate.protocolValue);
+	const __m128i flagsMask = _mm_set1_epi32(predicate.flagsMask);
+	const __m128i flagsValue = _mm_set1_epi32(predicate.flagsValue);
+	const __m128i regionMask = _mm_set1_epi32(predicate.regionMask);
+	const __m128i regionValue = _mm_set1_epi32(predicate.regionValue);
+	const __m128i zero = _mm_setzero_si128();
+	// disabled conditions are replaced with all bits set, so they're always true
+	const __m128i skipNotEmpty = _mm_set1_epi32(predicate.notEmpty ? 0 : -1);
+	const __m128i skipNotFull = _mm_set1_epi32(predicate.notFull ? 0 : -1);
+
+	size_t i = first;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i players = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_players[i]));
+		const __m128i maxPlayers = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_maxPlayers[i]));
+		__m128i match = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_gamedirs[i])), gamedirId);
+		match = _mm_and_si128(match, _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_maps[i])), mapMask), mapValue));
+		match = _mm_and_si128(match, _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_protocols[i])), protocolMask), protocolValue));
+		match = _mm_and_si128(match, _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_flags[i])), flagsMask), flagsValue));
+		match = _mm_and_si128(match, _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_regions[i])), regionMask), regionValue));
+		match = _mm_and_si128(match, _mm_or_si128(_mm_cmpgt_epi32(players, zero), skipNotEmpty));
+		match = _mm_and_si128(match, _mm_or_si128(_mm_cmplt_epi32(players, maxPlayers), skipNotFull));
+
+		const int32_t mask = _mm_movemask_ps(_mm_castsi128_ps(match));
+		for (int32_t j = 0; mask >> j; j++)
+		{
+			if (mask & (1 << j)) {
+				rows.push_back(i + j);
+			}
+		}
+	}
+	return i;
+#else
+	return first;
+#endif
+}
+
+#if CPU_X86 == 1
+CPU_TARGET_AVX2 size_t ServerTable::SelectAvx2(const Predicate &predicate, size_t first, std::vector<uint32_t> &rows) const
+{
+	const size_t count = m_addresses.size();
+	const __m256i gamedirId = _mm256_set1_epi32(predicate.gamedirId);
+	const __m256i mapMask = _mm256_set1_epi32(predicate.mapMask);
+	const __m256i mapValue = _mm256_set1_epi32(predicate.mapValue);
+	const __m256i protocolMask = _mm256_set1_epi32(predicate.protocolMask);
+	const __m256i protocolValue = _mm256_set1_epi32(predicate.protocolValue);
+	const __m256i flagsMask = _mm256_set1_epi32(predicate.flagsMask);
+	const __m256i flagsValue = _mm256_set1_epi32(predicate.flagsValue);
+	const __m256i regionMask = _mm256_set1_epi32(predicate.regionMask);
+	const __m256i regionValue = _mm256_set1_epi32(predicate.regionValue);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i skipNotEmpty = _mm256_set1_epi32(predicate.notEmpty ? 0 : -1);
+	const __m256i skipNotFull = _mm256_set1_epi32(predicate.notFull ? 0 : -1);
+
+	size_t i = first;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i players = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_players[i]));
+		const __m256i maxPlayers = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_maxPlayers[i]));
+		__m256i match = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_gamedirs[i])), gamedirId);
+		match = _mm256_and_si256(match, _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_maps[i])), mapMask), mapValue));
+		match = _mm256_and_si256(match, _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_protocols[i])), protocolMask), protocolValue));
+		match = _mm256_and_si256(match, _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_flags[i])), flagsMask), flagsValue));
+		match = _mm256_and_si256(match, _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_regions[i])), regionMask), regionValue));
+		match = _mm256_and_si256(match, _mm256_or_si256(_mm256_cmpgt_epi32(players, zero), skipNotEmpty));
+		match = _mm256_and_si256(match, _mm256_or_si256(_mm256_cmpgt_epi32(maxPlayers, players), skipNotFull));
+
+		const int32_t mask = _mm256_movemask_ps(_mm256_castsi256_ps(match));
+		for (int32_t j = 0; mask >> j; j++)
+		{
+			if (mask & (1 << j)) {
+				rows.push_back(i + j);
+			}
+		}
+	}
+	return i;
+}
+#else
+size_t ServerTable::SelectAvx2(const Predicate &predicate, size_t first, std::vector<uint32_t> &rows) const
+{
+	return first;
+}
+#endif
@@ -0,0 +1,86 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "net_address.h"
+#include "server_entry.h"
+#include "server_filter.h"
+#include "query_cache.h"
+#include "flat_hash_map.h"
+#include <vector>
+#include <optional>
+#include <stdint.h>
+
+// copy of servers fields used by filtered queries, stored as separate contiguous columns,
+// so predicate could be evaluated for several rows at once with SIMD instructions
+class ServerTable
+{
+public:
+	static constexpr size_t WireAddressStride = 18; // IPv6 address with port
+
+	enum Flags : uint32_t
+	{
+		FlagIPv6 = 1 << 0,
+		FlagNatBypass = 1 << 1,
+		FlagPassword = 1 << 2,
+		FlagDedicated = 1 << 3,
+	};
+
+	// row matches when every masked column equals to expected value
+	struct Predicate
+	{
+		uint32_t gamedirId;
+		uint32_t mapMask;
+		uint32_t mapValue;
+		uint32_t protocolMask;
+		uint32_t protocolValue;
+		uint32_t flagsMask;
+		uint32_t flagsValue;
+		uint32_t regionMask;
+		uint32_t regionValue;
+		bool notEmpty;
+		bool notFull;
+	};
+
+	void Update(const ServerEntry &entry);
+	void Remove(const NetAddress &address);
+	static Predicate MakePredicate(const ServerQuery &query, 
+		const ServerFilter &filter, 
+		uint32_t gamedirId, 
+		std::optional<uint32_t> mapId);
+
+	void Select(const Predicate &predicate, std::vector<uint32_t> &rows) const;
+
+	size_t GetRowsCount() const { return m_addresses.size(); }
+	const NetAddress &GetAddress(size_t row) const { return m_addresses[row]; }
+	const uint8_t *GetWireAddress(size_t row) const { return m_wireAddresses.data() + row * WireAddressStride; }
+
+private:
+	void WriteRow(size_t row, const ServerEntry &entry);
+
+	size_t SelectScalar(const Predicate &predicate, size_t first, std::vector<uint32_t> &rows) const;
+	size_t SelectSse2(const Predicate &predicate, size_t first, std::vector<uint32_t> &rows) const;
+	size_t SelectAvx2(const Predicate &predicate, size_t first, std::vector<uint32_t> &rows) const;
+
+	std::vector<uint32_t> m_gamedirs; // IDs of strings from pool
+	std::vector<uint32_t> m_maps;
+	std::vector<uint32_t> m_protocols;
+	std::vector<uint32_t> m_flags;
+	std::vector<uint32_t> m_players;
+	std::vector<uint32_t> m_maxPlayers;
+	std::vector<uint32_t> m_regions;
+	std::vector<uint8_t> m_wireAddresses;
+	std::vector<NetAddress> m_addresses;
+	FlatHashMap<NetAddress, size_t, NetAddressPortHash> m_rows;
+};
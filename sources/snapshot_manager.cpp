@@ -0,0 +1,171 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "snapshot_manager.h"
+#include "mapped_file.h"
+#include "binary_input_stream.h"
+#include "binary_output_stream.h"
+#include "utils.h"
+#include "build.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <system_error>
+#if BUILD_POSIX == 1
+#include <unistd.h>
+#endif
+
+static int64_t GetWallClockTime()
+{
+	auto duration = std::chrono::system_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
+SnapshotManager::SnapshotManager(const std::filesystem::path &path) :
+	m_path(path),
+	m_pendingTime(0),
+	m_pending(false),
+	m_stopRequested(false),
+	m_lastSize(0)
+{
+	m_writerThread = std::thread(&SnapshotManager::WriterThread, this);
+}
+
+SnapshotManager::~SnapshotManager()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stopRequested = true;
+	}
+	m_condition.notify_one();
+	m_writerThread.join();
+}
+
+bool SnapshotManager::Load(ServerList &serverList) const
+{
+	std::error_code error;
+	if (!std::filesystem::exists(m_path, error)) {
+		return false;
+	}
+
+	try {
+		MappedFile file(m_path);
+		BinaryInputStream stream(file.GetData(), file.GetSize());
+		const uint32_t magic = stream.Read<uint32_t>();
+		const uint16_t version = stream.Read<uint16_t>();
+		stream.SkipBytes(sizeof(uint16_t)); // reserved
+		const int64_t writeTime = stream.Read<int64_t>();
+
+		if (stream.Underflowed() || magic != Magic || version != Version) 
+		{
+			Utils::Log("Snapshot {} has unsupported format, ignoring it\n", m_path.string());
+			return false;
+		}
+
+		// monotonic clock is restarted too, so wall clock is used to count time while program wasn't running
+		const int64_t downtime = std::max<int64_t>(GetWallClockTime() - writeTime, 0);
+		if (!serverList.ReadSnapshot(stream, downtime)) 
+		{
+			Utils::Log("Snapshot {} is corrupted, ignoring it\n", m_path.string());
+			return false;
+		}
+	}
+	catch (const std::exception &ex) 
+	{
+		Utils::Log("Failed to load snapshot {}: {}\n", m_path.string(), ex.what());
+		return false;
+	}
+	return true;
+}
+
+void SnapshotManager::Save(ServerListSnapshot &&snapshot)
+{
+	const int64_t writeTime = GetWallClockTime();
+	{
+		// if previous snapshot isn't written yet, it's just replaced with newer one
+		std::lock_guard lock(m_mutex);
+		m_pendingSnapshot = std::move(snapshot);
+		m_pendingTime = writeTime;
+		m_pending = true;
+	}
+	m_condition.notify_one();
+}
+
+void SnapshotManager::WriterThread()
+{
+	ServerListSnapshot snapshot;
+	std::vector<uint8_t> data;
+	while (true)
+	{
+		int64_t writeTime;
+		{
+			std::unique_lock lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_pending || m_stopRequested; });
+			if (!m_pending) {
+				return; // stop requested and everything is written
+			}
+			snapshot = std::move(m_pendingSnapshot);
+			writeTime = m_pendingTime;
+			m_pending = false;
+		}
+		Serialize(snapshot, writeTime, data);
+		WriteFile(data);
+	}
+}
+
+void SnapshotManager::Serialize(const ServerListSnapshot &snapshot, int64_t writeTime, std::vector<uint8_t> &data)
+{
+	data.reserve(m_lastSize + m_lastSize / 4);
+	BinaryOutputStream stream(data);
+	stream.Write<uint32_t>(Magic);
+	stream.Write<uint16_t>(Version);
+	stream.Write<uint16_t>(0);
+	stream.Write<int64_t>(writeTime);
+	snapshot.Write(stream);
+	m_lastSize = data.size();
+}
+
+bool SnapshotManager::WriteFile(const std::vector<uint8_t> &data) const
+{
+	std::filesystem::path tempPath = m_path;
+	tempPath += ".tmp";
+
+	std::FILE *file = std::fopen(tempPath.string().c_str(), "wb");
+	if (!file) 
+	{
+		Utils::Log("Failed to create snapshot file {}\n", tempPath.string());
+		return false;
+	}
+
+	bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+	written = written && std::fflush(file) == 0;
+#if BUILD_POSIX == 1
+	written = written && fsync(fileno(file)) == 0; // data should be on disk before rename
+#endif
+	std::fclose(file);
+	if (!written) 
+	{
+		Utils::Log("Failed to write snapshot file {}\n", tempPath.string());
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, m_path, error);
+	if (error) 
+	{
+		Utils::Log("Failed to replace snapshot file {}: {}\n", m_path.string(), error.message());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,53 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "server_list.h"
+#include <filesystem>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+// keeps server list between restarts. caller only copies list state under lock, and it's
+// serialized on background thread and written to temporary file which is then renamed,
+// so existing snapshot is never left partially written
+class SnapshotManager
+{
+public:
+	SnapshotManager(const std::filesystem::path &path);
+	~SnapshotManager(); // waits until last saved snapshot is written
+
+	bool Load(ServerList &serverList) const;
+	void Save(ServerListSnapshot &&snapshot);
+
+private:
+	static constexpr uint32_t Magic = 0x53534D58; // "XMSS"
+	static constexpr uint16_t Version = 1;
+
+	void WriterThread();
+	void Serialize(const ServerListSnapshot &snapshot, int64_t writeTime, std::vector<uint8_t> &data);
+	bool WriteFile(const std::vector<uint8_t> &data) const;
+
+	std::filesystem::path m_path;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	ServerListSnapshot m_pendingSnapshot;
+	int64_t m_pendingTime;
+	bool m_pending;
+	bool m_stopRequested;
+	size_t m_lastSize; // accessed only from writer thread
+	std::thread m_writerThread;
+};
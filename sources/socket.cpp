@@ -14,7 +14,9 @@ GNU General Public License for more details.
 
 #include "socket.h"
 #include <stdexcept>
+#include <algorithm>
 #include <cstring>
+#include <cerrno>
 
 #if BUILD_WIN32 == 1
 #include <ws2tcpip.h>
@@ -22,7 +24,8 @@ GNU General Public License for more details.
 #include <unistd.h>
 #endif
 
-Socket::Socket(int32_t af, int32_t type, int32_t protocol)
+Socket::Socket(int32_t af, int32_t type, int32_t protocol) :
+	m_sendQueueLength(0)
 {
 	m_addressFamily = af;
 	m_socket = socket(af, type, protocol);
@@ -36,7 +39,16 @@ Socket::Socket(int32_t af, int32_t type, int32_t protocol)
 			throw std::runtime_error("IPV6_V6ONLY setsockopt failed");
 		}
 	}
-	m_dataBuffer.resize(4096);
+	if (evutil_make_socket_nonblocking(m_socket) != 0) {
+		throw std::runtime_error("failed to make socket non-blocking");
+	}
+#if BUILD_LINUX == 1
+	// not critical if it fails, kernel drops counter just won't be reported then
+	int overflowFlag = 1;
+	setsockopt(m_socket, SOL_SOCKET, SO_RXQ_OVFL, &overflowFlag, sizeof(overflowFlag));
+#endif
+	SetRecvBatchSize(1);
+	SetSendBatchSize(1);
 }
 
 Socket::~Socket()
@@ -48,6 +60,19 @@ Socket::Socket(Socket &&rhs) noexcept
 {
 	m_socket = rhs.m_socket;
 	m_addressFamily = rhs.m_addressFamily;
+	m_recvBuffers = std::move(rhs.m_recvBuffers);
+	m_recvDatagrams = std::move(rhs.m_recvDatagrams);
+	m_sendQueue = std::move(rhs.m_sendQueue);
+	m_sendArena = std::move(rhs.m_sendArena);
+	m_sendQueueLength = rhs.m_sendQueueLength;
+	m_statistics = rhs.m_statistics;
+#if BUILD_LINUX == 1
+	m_recvControl = std::move(rhs.m_recvControl);
+	m_recvVectors = std::move(rhs.m_recvVectors);
+	m_recvHeaders = std::move(rhs.m_recvHeaders);
+	m_sendVectors = std::move(rhs.m_sendVectors);
+	m_sendHeaders = std::move(rhs.m_sendHeaders);
+#endif
 	rhs.m_socket = NULL;
 	rhs.m_addressFamily = NULL;
 }
@@ -56,6 +81,19 @@ Socket &Socket::operator=(Socket &&rhs) noexcept
 {
 	m_socket = rhs.m_socket;
 	m_addressFamily = rhs.m_addressFamily;
+	m_recvBuffers = std::move(rhs.m_recvBuffers);
+	m_recvDatagrams = std::move(rhs.m_recvDatagrams);
+	m_sendQueue = std::move(rhs.m_sendQueue);
+	m_sendArena = std::move(rhs.m_sendArena);
+	m_sendQueueLength = rhs.m_sendQueueLength;
+	m_statistics = rhs.m_statistics;
+#if BUILD_LINUX == 1
+	m_recvControl = std::move(rhs.m_recvControl);
+	m_recvVectors = std::move(rhs.m_recvVectors);
+	m_recvHeaders = std::move(rhs.m_recvHeaders);
+	m_sendVectors = std::move(rhs.m_sendVectors);
+	m_sendHeaders = std::move(rhs.m_sendHeaders);
+#endif
 	rhs.m_socket = NULL;
 	rhs.m_addressFamily = NULL;
 	return *this;
@@ -63,96 +101,317 @@ Socket &Socket::operator=(Socket &&rhs) noexcept
 
 void Socket::Bind(const NetAddress &addr)
 {
-	sockaddr *actualAddr;
-	size_t sockaddrSize;
-	sockaddr_in address_v4;
-	sockaddr_in6 address_v6;
+	if (bind(m_socket, addr.GetSockaddr(), addr.GetSockaddrLength()) != 0) {
+		throw std::runtime_error("failed to bind socket");
+	}
+}
+
+void Socket::EnableReusePort()
+{
+#ifdef SO_REUSEPORT
+	int flag = 1;
+	if (setsockopt(m_socket, SOL_SOCKET, SO_REUSEPORT, (char *)&flag, sizeof(flag)) != 0) {
+		throw std::runtime_error("SO_REUSEPORT setsockopt failed");
+	}
+#else
+	throw std::runtime_error("SO_REUSEPORT is not supported on this platform");
+#endif
+}
 
-	std::memset(&address_v4, 0, sizeof(address_v4));
-	std::memset(&address_v6, 0, sizeof(address_v6));
-	if (addr.GetAddressFamily() == NetAddress::AddressFamily::IPv4) 
+void Socket::SetRecvBatchSize(size_t count)
+{
+	count = std::max<size_t>(count, 1);
+	m_recvBuffers.resize(count * MaxDatagramSize);
+	m_recvDatagrams.assign(count, Datagram{ NetAddress(GetNetAddressFamily()), nullptr, 0 });
+
+#if BUILD_LINUX == 1
+	// headers are pointing to the slots of ring, so they could be reused for every call.
+	// source addresses are written by kernel right into datagrams, without conversion
+	m_recvControl.resize(count * RecvControlSize);
+	m_recvVectors.resize(count);
+	m_recvHeaders.resize(count);
+	for (size_t i = 0; i < count; i++)
 	{
-		actualAddr = reinterpret_cast<sockaddr*>(&address_v4);
-		sockaddrSize = sizeof(address_v4);
-		addr.ToSockadr(&address_v4);
+		m_recvVectors[i].iov_base = m_recvBuffers.data() + i * MaxDatagramSize;
+		m_recvVectors[i].iov_len = MaxDatagramSize;
+		std::memset(&m_recvHeaders[i], 0, sizeof(m_recvHeaders[i]));
+		m_recvHeaders[i].msg_hdr.msg_name = m_recvDatagrams[i].source.GetSockaddr();
+		m_recvHeaders[i].msg_hdr.msg_iov = &m_recvVectors[i];
+		m_recvHeaders[i].msg_hdr.msg_iovlen = 1;
+		m_recvHeaders[i].msg_hdr.msg_control = m_recvControl.data() + i * RecvControlSize;
 	}
-	else
+#endif
+}
+
+size_t Socket::RecvBatch(size_t maxCount)
+{
+	const size_t count = std::min(maxCount, m_recvDatagrams.size());
+	if (count == 0) {
+		return 0;
+	}
+
+	// errors like ECONNREFUSED caused by ICMP are reported once and then cleared,
+	// so they're just counted, and socket is read again while attempts are left
+	for (size_t attempt = 0; attempt < count; attempt++)
 	{
-		actualAddr = reinterpret_cast<sockaddr*>(&address_v6);
-		sockaddrSize = sizeof(address_v6);
-		addr.ToSockadr(&address_v6);
+#if BUILD_LINUX == 1
+		for (size_t i = 0; i < count; i++) 
+		{
+			m_recvHeaders[i].msg_hdr.msg_namelen = NetAddress::MaxSockaddrLength;
+			m_recvHeaders[i].msg_hdr.msg_controllen = RecvControlSize;
+		}
+
+		int32_t received = recvmmsg(m_socket, m_recvHeaders.data(), count, MSG_DONTWAIT, nullptr);
+		m_statistics.recvCalls += 1;
+		if (received < 0)
+		{
+			if (IsWouldBlockError()) {
+				return 0; // socket queue is drained
+			}
+			m_statistics.recvErrors += 1;
+			continue;
+		}
+
+		size_t stored = 0;
+		for (int32_t i = 0; i < received; i++)
+		{
+			const msghdr &header = m_recvHeaders[i].msg_hdr;
+			for (cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg != nullptr; cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&header), cmsg))
+			{
+				if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) 
+				{
+					uint32_t dropsCount;
+					std::memcpy(&dropsCount, CMSG_DATA(cmsg), sizeof(dropsCount));
+					m_statistics.kernelDrops = dropsCount; // kernel reports total amount for socket
+				}
+			}
+
+			if (header.msg_flags & MSG_TRUNC) 
+			{
+				m_statistics.truncatedDatagrams += 1;
+				continue;
+			}
+			StoreDatagram(stored, i, m_recvHeaders[i].msg_len);
+			stored += 1;
+		}
+#else
+		// no batched receive available here, so take only single datagram per call
+		socklen_t sockaddrSize = NetAddress::MaxSockaddrLength;
+		sockaddr *actualAddr = m_recvDatagrams[0].source.GetSockaddr();
+		char *dataAddr = reinterpret_cast<char*>(m_recvBuffers.data());
+		int32_t bytesCount = recvfrom(m_socket, dataAddr, MaxDatagramSize, 0, actualAddr, &sockaddrSize);
+		m_statistics.recvCalls += 1;
+		if (bytesCount < 0)
+		{
+			if (IsWouldBlockError()) {
+				return 0;
+			}
+#if BUILD_WIN32 == 1
+			if (WSAGetLastError() == WSAEMSGSIZE) 
+			{
+				m_statistics.truncatedDatagrams += 1;
+				continue;
+			}
+#endif
+			m_statistics.recvErrors += 1;
+			continue;
+		}
+
+		StoreDatagram(0, 0, bytesCount);
+		size_t stored = 1;
+#endif
+		if (stored > 0) 
+		{
+			m_statistics.receivedDatagrams += stored;
+			return stored;
+		}
 	}
-	
-	if (bind(m_socket, actualAddr, sockaddrSize) != 0) {
-		throw std::runtime_error("failed to bind socket");
+	return 0;
+}
+
+bool Socket::SendTo(const NetAddress &destination, const uint8_t *buffer, size_t dataSize)
+{
+	const char *dataAddress = reinterpret_cast<const char*>(buffer);
+	if (sendto(m_socket, dataAddress, dataSize, 0, destination.GetSockaddr(), destination.GetSockaddrLength()) != dataSize) {
+		return false;
 	}
+	return true;
 }
 
-NetAddress Socket::RecvFrom()
+void Socket::SetSendBatchSize(size_t count)
 {
-	sockaddr *actualAddr;
-	socklen_t sockaddrSize;
-	sockaddr_in address_v4;
-	sockaddr_in6 address_v6;
+	FlushSendQueue();
+	count = std::max<size_t>(count, 1);
+	m_sendQueue.resize(count);
+	m_sendArena.resize(count * MaxDatagramSize);
+#if BUILD_LINUX == 1
+	m_sendHeaders.resize(count);
+#endif
+}
+
+void Socket::QueueSendTo(const NetAddress &destination, const uint8_t *buffer, size_t dataSize)
+{
+	BinaryOutputStream stream = PrepareSend();
+	stream.WriteBytes(buffer, dataSize);
+	CommitSend(destination, stream);
+}
 
-	std::memset(&address_v4, 0, sizeof(address_v4));
-	std::memset(&address_v6, 0, sizeof(address_v6));
-	if (m_addressFamily == AF_INET) {
-		actualAddr = reinterpret_cast<sockaddr*>(&address_v4);
-		sockaddrSize = sizeof(address_v4);
+BinaryOutputStream Socket::PrepareSend()
+{
+	if (m_sendQueueLength == m_sendQueue.size()) {
+		FlushSendQueue();
 	}
-	else {
-		actualAddr = reinterpret_cast<sockaddr*>(&address_v6);
-		sockaddrSize = sizeof(address_v6);
+
+	OutgoingDatagram &datagram = m_sendQueue[m_sendQueueLength];
+	uint8_t *slot = m_sendArena.data() + m_sendQueueLength * MaxDatagramSize;
+	return BinaryOutputStream(slot, MaxDatagramSize, datagram.segments);
+}
+
+void Socket::CommitSend(const NetAddress &destination, BinaryOutputStream &stream, std::shared_ptr<const void> keepAlive)
+{
+	if (stream.Overflowed()) 
+	{
+		m_statistics.sendErrors += 1; // datagram doesn't fit into slot, so it's dropped
+		return;
 	}
 
-	m_dataBuffer.resize(m_dataBuffer.capacity());
-	char *dataAddr = reinterpret_cast<char*>(m_dataBuffer.data());
-	int32_t bytesCount = recvfrom(m_socket, dataAddr, m_dataBuffer.capacity(), 0, actualAddr, &sockaddrSize);
-	if (bytesCount == -1) {
-		throw std::runtime_error("recvfrom() returned error status");
+	OutgoingDatagram &datagram = m_sendQueue[m_sendQueueLength];
+	stream.Finish();
+	datagram.destination = destination;
+	datagram.keepAlive = std::move(keepAlive);
+	m_sendQueueLength += 1;
+}
+
+void Socket::FlushSendQueue()
+{
+	if (m_sendQueueLength == 0) {
+		return;
 	}
-	
-	m_dataBuffer.resize(bytesCount);
-	if (m_addressFamily == AF_INET) 
+
+#if BUILD_LINUX == 1
+	// segments of all datagrams are gathered by kernel, so they're never concatenated here
+	m_sendVectors.clear();
+	for (size_t i = 0; i < m_sendQueueLength; i++)
 	{
-		NetAddress addr(NetAddress::AddressFamily::IPv4);
-		addr.FromSockadr(&address_v4);
-		return addr;
+		for (const OutputSegment &segment : m_sendQueue[i].segments) {
+			m_sendVectors.push_back({ const_cast<uint8_t*>(segment.data), segment.size });
+		}
 	}
-	else 
+
+	size_t firstVector = 0;
+	for (size_t i = 0; i < m_sendQueueLength; i++)
 	{
-		NetAddress addr(NetAddress::AddressFamily::IPv6);
-		addr.FromSockadr(&address_v6);
-		return addr;
+		OutgoingDatagram &datagram = m_sendQueue[i];
+		std::memset(&m_sendHeaders[i], 0, sizeof(m_sendHeaders[i]));
+		m_sendHeaders[i].msg_hdr.msg_name = datagram.destination.GetSockaddr();
+		m_sendHeaders[i].msg_hdr.msg_namelen = datagram.destination.GetSockaddrLength();
+		m_sendHeaders[i].msg_hdr.msg_iov = m_sendVectors.data() + firstVector;
+		m_sendHeaders[i].msg_hdr.msg_iovlen = datagram.segments.size();
+		firstVector += datagram.segments.size();
 	}
-}
-
-bool Socket::SendTo(const NetAddress &destination, const uint8_t *buffer, size_t dataSize)
-{
-	sockaddr *actualAddr;
-	size_t sockaddrSize;
-	sockaddr_in address_v4;
-	sockaddr_in6 address_v6;
 
-	std::memset(&address_v4, 0, sizeof(address_v4));
-	std::memset(&address_v6, 0, sizeof(address_v6));
-	if (destination.GetAddressFamily() == NetAddress::AddressFamily::IPv4) 
+	size_t offset = 0;
+	while (offset < m_sendQueueLength)
 	{
-		actualAddr = reinterpret_cast<sockaddr*>(&address_v4);
-		sockaddrSize = sizeof(address_v4);
-		destination.ToSockadr(&address_v4);
+		int32_t sent = sendmmsg(m_socket, m_sendHeaders.data() + offset, m_sendQueueLength - offset, 0);
+		m_statistics.sendBatches += 1;
+		if (sent < 0)
+		{
+			if (errno == EINTR) {
+				continue;
+			}
+			else if (IsDatagramError()) 
+			{
+				// first datagram of the rest was rejected, drop it and try to send remaining ones
+				m_statistics.sendErrors += 1;
+				offset += 1;
+				continue;
+			}
+
+			// send buffer is full or socket itself is broken, so retrying would just spin here
+			if (!IsWouldBlockError()) {
+				m_statistics.sendErrors += 1;
+			}
+			m_statistics.droppedDatagrams += m_sendQueueLength - offset;
+			break;
+		}
+
+		m_statistics.sentDatagrams += sent;
+		offset += sent;
+		if (offset < m_sendQueueLength) {
+			m_statistics.partialSends += 1;
+		}
 	}
-	else
+#else
+	std::vector<uint8_t> gathered;
+	for (size_t i = 0; i < m_sendQueueLength; i++)
 	{
-		actualAddr = reinterpret_cast<sockaddr*>(&address_v6);
-		sockaddrSize = sizeof(address_v6);
-		destination.ToSockadr(&address_v6);
+		// there is no sendmmsg here, so segments are joined when there are several of them
+		const OutgoingDatagram &datagram = m_sendQueue[i];
+		const uint8_t *data = datagram.segments.empty() ? nullptr : datagram.segments[0].data;
+		size_t dataSize = datagram.segments.empty() ? 0 : datagram.segments[0].size;
+		if (datagram.segments.size() > 1)
+		{
+			gathered.clear();
+			for (const OutputSegment &segment : datagram.segments) {
+				gathered.insert(gathered.end(), segment.data, segment.data + segment.size);
+			}
+			data = gathered.data();
+			dataSize = gathered.size();
+		}
+
+		const sockaddr *actualAddr = datagram.destination.GetSockaddr();
+		const char *dataAddress = reinterpret_cast<const char*>(data);
+		if (sendto(m_socket, dataAddress, dataSize, 0, actualAddr, datagram.destination.GetSockaddrLength()) == dataSize) {
+			m_statistics.sentDatagrams += 1;
+		}
+		else if (IsWouldBlockError()) 
+		{
+			m_statistics.droppedDatagrams += m_sendQueueLength - i;
+			break;
+		}
+		else {
+			m_statistics.sendErrors += 1;
+		}
 	}
+	m_statistics.sendBatches += 1;
+#endif
 
-	const char *dataAddress = reinterpret_cast<const char*>(buffer);
-	if (sendto(m_socket, dataAddress, dataSize, 0, actualAddr, sockaddrSize) != dataSize) {
-		return false;
+	for (size_t i = 0; i < m_sendQueueLength; i++) {
+		m_sendQueue[i].keepAlive.reset(); // referenced data isn't needed anymore
 	}
-	return true;
+	m_sendQueueLength = 0;
+}
+
+void Socket::StoreDatagram(size_t index, size_t slot, size_t size)
+{
+	Datagram &datagram = m_recvDatagrams[index];
+	if (index != slot) {
+		datagram.source = m_recvDatagrams[slot].source; // some datagrams before were skipped
+	}
+	datagram.data = m_recvBuffers.data() + slot * MaxDatagramSize;
+	datagram.size = size;
+}
+
+#if BUILD_LINUX == 1
+bool Socket::IsDatagramError()
+{
+	// errors caused by particular datagram contents or destination, not by socket state
+	return errno == EMSGSIZE || errno == EHOSTUNREACH || errno == ENETUNREACH || 
+		errno == EAFNOSUPPORT || errno == EACCES || errno == EPERM || errno == EINVAL;
+}
+#endif
+
+bool Socket::IsWouldBlockError()
+{
+#if BUILD_WIN32 == 1
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+NetAddress::AddressFamily Socket::GetNetAddressFamily() const
+{
+	return (m_addressFamily == AF_INET6) ? NetAddress::AddressFamily::IPv6 : NetAddress::AddressFamily::IPv4;
 }
@@ -15,8 +15,10 @@ GNU General Public License for more details.
 #pragma once
 #include "build.h"
 #include "net_address.h"
+#include "binary_output_stream.h"
 #include <event2/util.h>
 #include <vector>
+#include <memory>
 #include <stdint.h>
 
 #if BUILD_WIN32 == 1
@@ -27,25 +29,93 @@ GNU General Public License for more details.
 #include <arpa/inet.h>
 #endif
 
+#if BUILD_LINUX == 1
+#include <sys/uio.h>
+#endif
+
+struct Datagram
+{
+	NetAddress source;
+	const uint8_t *data;
+	size_t size;
+};
+
+struct SocketStatistics
+{
+	uint64_t receivedDatagrams = 0;
+	uint64_t recvCalls = 0;
+	uint64_t recvErrors = 0;
+	uint64_t truncatedDatagrams = 0;
+	uint64_t kernelDrops = 0; // datagrams dropped by kernel due to full receive queue, if platform reports it
+	uint64_t sentDatagrams = 0;
+	uint64_t sendBatches = 0;
+	uint64_t partialSends = 0;
+	uint64_t sendErrors = 0;
+	uint64_t droppedDatagrams = 0; // queued ones which weren't sent because socket send buffer was full
+};
+
 class Socket
 {
 public:
+	static constexpr size_t MaxDatagramSize = 4096;
+
 	Socket(int32_t af, int32_t type, int32_t protocol);
 	~Socket();
 	Socket(Socket&& rhs) noexcept;
 	Socket& operator=(Socket&& rhs) noexcept;
 
 	void Bind(const NetAddress &addr);
-	NetAddress RecvFrom();
+	void EnableReusePort();
+	void SetRecvBatchSize(size_t count);
+	size_t RecvBatch(size_t maxCount);
 	bool SendTo(const NetAddress &destination, const uint8_t *buffer, size_t dataSize);
-	const std::vector<uint8_t> &GetDataBuffer() const { return m_dataBuffer; };
+	void SetSendBatchSize(size_t count);
+	void QueueSendTo(const NetAddress &destination, const uint8_t *buffer, size_t dataSize);
+	// datagram is serialized right into send queue, nothing else should be queued until it's committed.
+	// memory referenced by stream is kept alive by given pointer until datagram is sent
+	BinaryOutputStream PrepareSend();
+	void CommitSend(const NetAddress &destination, BinaryOutputStream &stream, std::shared_ptr<const void> keepAlive = nullptr);
+	void FlushSendQueue();
+	const Datagram &GetDatagram(size_t index) const { return m_recvDatagrams[index]; }
+	size_t GetRecvBatchSize() const { return m_recvDatagrams.size(); }
 	evutil_socket_t GetDescriptor() const { return m_socket; }
+	const SocketStatistics &GetStatistics() const { return m_statistics; }
 
 private:
+	struct OutgoingDatagram
+	{
+		NetAddress destination = NetAddress(NetAddress::AddressFamily::IPv4);
+		std::vector<OutputSegment> segments; // point to slot in send arena, or to memory held by keepAlive
+		std::shared_ptr<const void> keepAlive;
+	};
+
+#if BUILD_LINUX == 1
+	static constexpr size_t RecvControlSize = CMSG_SPACE(sizeof(uint32_t)); // enough for SO_RXQ_OVFL counter
+#endif
+
 	Socket(const Socket&) = delete;
 	Socket& operator=(const Socket&) = delete;
 
+	NetAddress::AddressFamily GetNetAddressFamily() const;
+	void StoreDatagram(size_t index, size_t slot, size_t size);
+	static bool IsWouldBlockError();
+#if BUILD_LINUX == 1
+	static bool IsDatagramError();
+#endif
+
 	evutil_socket_t m_socket;
 	int32_t m_addressFamily;
-	std::vector<uint8_t> m_dataBuffer;
+	std::vector<uint8_t> m_recvBuffers; // one slot of MaxDatagramSize bytes per datagram in batch
+	std::vector<Datagram> m_recvDatagrams;
+	std::vector<OutgoingDatagram> m_sendQueue; // slots are reused to keep their buffers allocated
+	std::vector<uint8_t> m_sendArena; // one slot of MaxDatagramSize bytes per queued datagram
+	size_t m_sendQueueLength;
+	SocketStatistics m_statistics;
+#if BUILD_LINUX == 1
+	std::vector<uint8_t> m_recvControl;
+	std::vector<iovec> m_recvVectors;
+	std::vector<mmsghdr> m_recvHeaders;
+	std::vector<iovec> m_sendVectors;
+	std::vector<mmsghdr> m_sendHeaders;
+#endif
 };
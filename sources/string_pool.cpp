@@ -0,0 +1,127 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "string_pool.h"
+
+InternedString::InternedString(StringPoolEntry *entry) :
+	m_entry(entry)
+{
+	m_entry->refCount += 1;
+}
+
+InternedString::InternedString(const InternedString &rhs) :
+	m_entry(rhs.m_entry)
+{
+	if (m_entry) {
+		m_entry->refCount += 1;
+	}
+}
+
+InternedString::InternedString(InternedString &&rhs) noexcept :
+	m_entry(rhs.m_entry)
+{
+	rhs.m_entry = nullptr;
+}
+
+InternedString &InternedString::operator=(const InternedString &rhs)
+{
+	if (m_entry != rhs.m_entry)
+	{
+		Release();
+		m_entry = rhs.m_entry;
+		if (m_entry) {
+			m_entry->refCount += 1;
+		}
+	}
+	return *this;
+}
+
+InternedString &InternedString::operator=(InternedString &&rhs) noexcept
+{
+	if (this != &rhs)
+	{
+		Release();
+		m_entry = rhs.m_entry;
+		rhs.m_entry = nullptr;
+	}
+	return *this;
+}
+
+InternedString::~InternedString()
+{
+	Release();
+}
+
+const std::string &InternedString::Get() const
+{
+	static const std::string emptyString;
+	return m_entry ? m_entry->value : emptyString;
+}
+
+uint32_t InternedString::GetId() const
+{
+	return m_entry ? m_entry->id : StringPool::InvalidId;
+}
+
+void InternedString::Release()
+{
+	if (m_entry)
+	{
+		m_entry->refCount -= 1;
+		if (m_entry->refCount == 0) {
+			m_entry->pool->Remove(m_entry);
+		}
+		m_entry = nullptr;
+	}
+}
+
+InternedString StringPool::Intern(std::string_view value)
+{
+	auto it = m_entries.find(value);
+	if (it != m_entries.end()) {
+		return InternedString(it->second.get());
+	}
+
+	auto entry = std::make_unique<StringPoolEntry>();
+	entry->value = std::string(value);
+	entry->refCount = 0;
+	entry->pool = this;
+	if (!m_freeIds.empty())
+	{
+		entry->id = m_freeIds.back();
+		m_freeIds.pop_back();
+	}
+	else {
+		entry->id = m_nextId++;
+	}
+
+	StringPoolEntry *entryPtr = entry.get();
+	m_entries.insert({ std::string_view(entryPtr->value), std::move(entry) });
+	return InternedString(entryPtr);
+}
+
+std::optional<uint32_t> StringPool::FindId(std::string_view value) const
+{
+	auto it = m_entries.find(value);
+	if (it != m_entries.end()) {
+		return it->second->id;
+	}
+	return std::nullopt;
+}
+
+void StringPool::Remove(StringPoolEntry *entry)
+{
+	m_freeIds.push_back(entry->id);
+	m_entries.erase(std::string_view(entry->value));
+}
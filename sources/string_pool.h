@@ -0,0 +1,80 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <stdint.h>
+
+class StringPool;
+
+struct StringPoolEntry
+{
+	std::string value;
+	uint32_t id;
+	size_t refCount;
+	StringPool *pool;
+};
+
+// handle to string stored in pool, string is removed from pool when last handle to it is gone
+class InternedString
+{
+public:
+	InternedString() = default;
+	InternedString(const InternedString &rhs);
+	InternedString(InternedString &&rhs) noexcept;
+	InternedString &operator=(const InternedString &rhs);
+	InternedString &operator=(InternedString &&rhs) noexcept;
+	~InternedString();
+
+	bool operator==(const InternedString &rhs) const { return m_entry == rhs.m_entry; }
+	bool operator!=(const InternedString &rhs) const { return m_entry != rhs.m_entry; }
+	const std::string &Get() const;
+	uint32_t GetId() const;
+
+private:
+	friend class StringPool;
+	explicit InternedString(StringPoolEntry *entry);
+	void Release();
+
+	StringPoolEntry *m_entry = nullptr;
+};
+
+// keeps single copy of every distinct string, so entries could share them and compare by ID.
+// it's not thread-safe, handles should be copied and destroyed under the same lock as pool
+class StringPool
+{
+public:
+	static constexpr uint32_t InvalidId = 0;
+
+	StringPool() = default;
+	StringPool(const StringPool&) = delete;
+	StringPool &operator=(const StringPool&) = delete;
+
+	InternedString Intern(std::string_view value);
+	std::optional<uint32_t> FindId(std::string_view value) const;
+	size_t GetCount() const { return m_entries.size(); }
+
+private:
+	friend class InternedString;
+	void Remove(StringPoolEntry *entry);
+
+	std::unordered_map<std::string_view, std::unique_ptr<StringPoolEntry>> m_entries; // keys are pointing to entries values
+	std::vector<uint32_t> m_freeIds;
+	uint32_t m_nextId = InvalidId + 1;
+};
@@ -13,40 +13,42 @@ GNU General Public License for more details.
 */
 
 #pragma once
+#include "clock.h"
 #include <utility>
+#include <stdint.h>
 
+// keeps only time point in clock ticks, so it's cheap to store it per entry
 class Timer
 {
 public:
-	Timer();
-	Timer(double interval);
-	Timer(const Timer&) = default;
-	Timer(Timer&&) noexcept = default;
-	Timer& operator=(const Timer&) = default;
-	Timer& operator=(Timer&&) noexcept = default;
-
-	void Reset();
-	void SetInterval(double interval);
-	bool CycleElapsed() const;
-	bool IntervalElapsed(double interval) const;
+	Timer() : m_timePoint(0) {}
+
+	void Reset() { m_timePoint = Clock::GetTicks(); }
+	bool IntervalElapsed(double interval) const { return Clock::GetTicks() > m_timePoint + Clock::SecondsToTicks(interval); }
+	int64_t GetTimePoint() const { return m_timePoint; }
+	void SetTimePoint(int64_t timePoint) { m_timePoint = timePoint; }
 
 private:
-	double m_interval;
-	double m_timePoint;
+	int64_t m_timePoint;
 };
 
 template<class T> 
 class Expirable
 {
 public:
-	Expirable(const T& object) : m_value(object) { m_expirationTimer.Reset(); }
-	Expirable(T&& object) : m_value(std::move(object)) { m_expirationTimer.Reset(); }
+	Expirable(const T& object) : m_value(object), m_expirationTicket(0) { m_expirationTimer.Reset(); }
+	Expirable(T&& object) : m_value(std::move(object)), m_expirationTicket(0) { m_expirationTimer.Reset(); }
 
 	T& GetValue() { return m_value; }
 	const T& GetValue() const { return m_value; }
 	bool Expired(double interval) const { return m_expirationTimer.IntervalElapsed(interval); }
+	int64_t GetCreationTime() const { return m_expirationTimer.GetTimePoint(); }
+	void SetCreationTime(int64_t time) { m_expirationTimer.SetTimePoint(time); }
+	uint64_t GetExpirationTicket() const { return m_expirationTicket; }
+	void SetExpirationTicket(uint64_t ticket) { m_expirationTicket = ticket; }
 
 private:
 	T m_value;
 	Timer m_expirationTimer;
+	uint64_t m_expirationTicket; // ticket of timing wheel schedule
 };
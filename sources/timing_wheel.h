@@ -0,0 +1,86 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+// keeps deadlines of items in ring of slots, so on every advance only slots 
+// which time has come are visited, instead of checking every tracked item.
+// owner keeps ticket returned by Schedule() along with item, and uses it in callback 
+// to recognize outdated schedules (e.g. item was removed and added again meanwhile)
+template<class Key>
+class TimingWheel
+{
+public:
+	TimingWheel(size_t slotsCount, int64_t resolution, int64_t startTime) :
+		m_slots(slotsCount),
+		m_resolution(resolution),
+		m_currentTick(startTime / resolution),
+		m_nextTicket(1)
+	{
+	}
+
+	uint64_t Schedule(const Key &key, int64_t deadline)
+	{
+		// item is fired only when deadline is passed, and never into slot which is already processed
+		const int64_t tick = std::max(deadline / m_resolution + 1, m_currentTick + 1);
+		const uint64_t ticket = m_nextTicket++;
+		m_slots[tick % m_slots.size()].push_back(Item{ key, tick, ticket });
+		return ticket;
+	}
+
+	// callback receives key and ticket of every item with passed deadline, it could schedule items again
+	template<class F> void Advance(int64_t currentTime, F &&callback)
+	{
+		const int64_t newTick = currentTime / m_resolution;
+		if (newTick <= m_currentTick) {
+			return;
+		}
+
+		const int64_t steps = std::min<int64_t>(newTick - m_currentTick, m_slots.size());
+		const int64_t firstTick = m_currentTick + 1;
+		m_currentTick = newTick;
+		for (int64_t i = 0; i < steps; i++)
+		{
+			// items for next rounds of wheel are staying in slot
+			std::vector<Item> &slot = m_slots[(firstTick + i) % m_slots.size()];
+			m_firedItems.clear();
+			auto it = std::partition(slot.begin(), slot.end(), [newTick](const Item &item) { 
+				return item.tick > newTick; 
+			});
+			m_firedItems.assign(it, slot.end());
+			slot.erase(it, slot.end());
+
+			for (const Item &item : m_firedItems) {
+				callback(item.key, item.ticket);
+			}
+		}
+	}
+
+private:
+	struct Item
+	{
+		Key key;
+		int64_t tick;
+		uint64_t ticket;
+	};
+
+	std::vector<std::vector<Item>> m_slots;
+	std::vector<Item> m_firedItems;
+	int64_t m_resolution;
+	int64_t m_currentTick;
+	uint64_t m_nextTicket;
+};
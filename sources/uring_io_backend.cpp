@@ -0,0 +1,305 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#include "uring_io_backend.h"
+#include "utils.h"
+#include "clock.h"
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+UringIoBackend::UringIoBackend(ev::EventBase &eventBase,
+	RequestHandler &requestHandler,
+	const ConfigData &configData,
+	const std::vector<std::shared_ptr<Socket>> &sockets) :
+	m_eventBase(eventBase),
+	m_requestHandler(requestHandler),
+	m_configData(configData),
+	m_ringInitialized(false),
+	m_receiveUnsupported(false),
+	m_bufferRing(nullptr),
+	m_recycledBuffers(0),
+	m_eventDescriptor(-1)
+{
+	for (const auto &socket : sockets)
+	{
+		SocketContext context;
+		context.socket = socket;
+		context.receiveArmed = false;
+		std::memset(&context.messageHeader, 0, sizeof(context.messageHeader));
+		context.messageHeader.msg_namelen = NetAddress::MaxSockaddrLength;
+		m_sockets.push_back(context);
+	}
+
+	try {
+		Initialize(eventBase);
+	}
+	catch (...) {
+		Shutdown();
+		throw;
+	}
+}
+
+UringIoBackend::~UringIoBackend()
+{
+	Shutdown();
+}
+
+void UringIoBackend::Initialize(ev::EventBase &eventBase)
+{
+	int result = io_uring_queue_init(RingEntries, &m_ring, 0);
+	if (result < 0) {
+		throw std::runtime_error(fmt::format("io_uring_queue_init() failed: {}", std::strerror(-result)));
+	}
+	m_ringInitialized = true;
+
+	io_uring_probe *probe = io_uring_get_probe_ring(&m_ring);
+	const bool recvmsgSupported = probe && io_uring_opcode_supported(probe, IORING_OP_RECVMSG);
+	if (probe) {
+		io_uring_free_probe(probe);
+	}
+	if (!recvmsgSupported) {
+		throw std::runtime_error("IORING_OP_RECVMSG is not supported by kernel");
+	}
+
+	m_bufferRing = io_uring_setup_buf_ring(&m_ring, BufferCount, BufferGroup, 0, &result);
+	if (!m_bufferRing) {
+		throw std::runtime_error(fmt::format("provided buffers ring setup failed: {}", std::strerror(-result)));
+	}
+
+	m_buffers.resize(BufferCount * BufferSize);
+	for (uint32_t i = 0; i < BufferCount; i++) {
+		RecycleBuffer(i);
+	}
+	io_uring_buf_ring_advance(m_bufferRing, m_recycledBuffers);
+	m_recycledBuffers = 0;
+
+	m_eventDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_eventDescriptor < 0) {
+		throw std::runtime_error("failed to create eventfd");
+	}
+	if (io_uring_register_eventfd(&m_ring, m_eventDescriptor) < 0) {
+		throw std::runtime_error("failed to register eventfd in io_uring");
+	}
+
+	for (size_t i = 0; i < m_sockets.size(); i++) {
+		ArmReceive(i);
+	}
+	io_uring_submit(&m_ring);
+	CheckReceiveSupport();
+
+	auto completionCallback = [](evutil_socket_t fd, short event, void *arg) {
+		UringIoBackend *backend = reinterpret_cast<UringIoBackend*>(arg);
+		backend->CompletionCallback();
+	};
+
+	m_completionEvent = std::make_unique<ev::Event>(
+		eventBase,
+		m_eventDescriptor,
+		EV_READ | EV_PERSIST,
+		completionCallback,
+		this
+	);
+	m_completionEvent->Add();
+}
+
+void UringIoBackend::Shutdown()
+{
+	m_completionEvent.reset();
+	if (m_ringInitialized)
+	{
+		if (m_bufferRing) 
+		{
+			io_uring_free_buf_ring(&m_ring, m_bufferRing, BufferCount, BufferGroup);
+			m_bufferRing = nullptr;
+		}
+		io_uring_queue_exit(&m_ring);
+		m_ringInitialized = false;
+	}
+	if (m_eventDescriptor >= 0) 
+	{
+		close(m_eventDescriptor);
+		m_eventDescriptor = -1;
+	}
+}
+
+void UringIoBackend::ArmReceive(size_t socketIndex)
+{
+	SocketContext &context = m_sockets[socketIndex];
+	io_uring_sqe *sqe = io_uring_get_sqe(&m_ring);
+	if (!sqe) 
+	{
+		io_uring_submit(&m_ring);
+		sqe = io_uring_get_sqe(&m_ring);
+	}
+
+	io_uring_prep_recvmsg_multishot(sqe, context.socket->GetDescriptor(), &context.messageHeader, 0);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = BufferGroup;
+	io_uring_sqe_set_data64(sqe, socketIndex);
+	context.receiveArmed = true;
+}
+
+void UringIoBackend::CheckReceiveSupport()
+{
+	// depending on kernel, unsupported multishot recvmsg is rejected either at submission
+	// or asynchronously a bit later, so all completions posted during short window are checked
+	__kernel_timespec timeout = { 0, ProbeTimeout };
+	io_uring_cqe *cqe = nullptr;
+	int result = io_uring_wait_cqe_timeout(&m_ring, &cqe, &timeout);
+	while (result == 0 && cqe)
+	{
+		if (IsReceiveUnsupported(cqe)) {
+			throw std::runtime_error(fmt::format("multishot recvmsg is not supported: {}", std::strerror(-cqe->res)));
+		}
+		HandleCompletion(cqe); // datagrams could arrive already, so they're handled as usual
+		io_uring_cqe_seen(&m_ring, cqe);
+		result = io_uring_peek_cqe(&m_ring, &cqe);
+	}
+	io_uring_buf_ring_advance(m_bufferRing, m_recycledBuffers);
+	m_recycledBuffers = 0;
+
+	// requests terminated for other reasons (e.g. buffers drained by traffic) are armed again,
+	// and replies to datagrams handled here shouldn't wait for first completion callback
+	bool needSubmit = false;
+	for (size_t i = 0; i < m_sockets.size(); i++)
+	{
+		m_sockets[i].socket->FlushSendQueue();
+		if (!m_sockets[i].receiveArmed) 
+		{
+			ArmReceive(i);
+			needSubmit = true;
+		}
+	}
+	if (needSubmit) {
+		io_uring_submit(&m_ring);
+	}
+}
+
+bool UringIoBackend::IsReceiveUnsupported(const io_uring_cqe *cqe)
+{
+	// other errors like ENOBUFS just terminate request, and it's armed again later
+	return !(cqe->flags & IORING_CQE_F_MORE) && (cqe->res == -EINVAL || cqe->res == -EOPNOTSUPP);
+}
+
+void UringIoBackend::SwitchToFallback()
+{
+	Utils::Log("Multishot recvmsg failed after start, falling back to libevent\n");
+	std::vector<std::shared_ptr<Socket>> sockets;
+	for (const SocketContext &context : m_sockets) {
+		sockets.push_back(context.socket);
+	}
+	m_fallbackBackend = std::make_unique<LibeventIoBackend>(m_eventBase, m_requestHandler, m_configData, sockets);
+}
+
+void UringIoBackend::CompletionCallback()
+{
+	eventfd_t counter;
+	eventfd_read(m_eventDescriptor, &counter);
+	Clock::Update(); // whole batch of completions is handled with single clock sample
+
+	io_uring_cqe *cqes[64];
+	size_t budget = m_configData.GetRecvBudget();
+	while (budget > 0)
+	{
+		const uint32_t count = io_uring_peek_batch_cqe(&m_ring, cqes, std::min<size_t>(budget, std::size(cqes)));
+		if (count == 0) {
+			break;
+		}
+
+		for (uint32_t i = 0; i < count; i++) {
+			HandleCompletion(cqes[i]);
+		}
+		io_uring_cq_advance(&m_ring, count);
+		budget -= count;
+	}
+
+	io_uring_buf_ring_advance(m_bufferRing, m_recycledBuffers);
+	m_recycledBuffers = 0;
+
+	if (m_receiveUnsupported && !m_fallbackBackend) {
+		SwitchToFallback();
+	}
+
+	bool needSubmit = false;
+	for (size_t i = 0; i < m_sockets.size(); i++)
+	{
+		m_sockets[i].socket->FlushSendQueue(); // send all replies produced by this batch at once
+		if (!m_sockets[i].receiveArmed && !m_fallbackBackend) 
+		{
+			ArmReceive(i);
+			needSubmit = true;
+		}
+	}
+	if (needSubmit) {
+		io_uring_submit(&m_ring);
+	}
+
+	// eventfd won't be signaled again for completions that are already posted
+	if (io_uring_cq_ready(&m_ring) > 0) {
+		m_completionEvent->Activate(EV_READ);
+	}
+}
+
+void UringIoBackend::HandleCompletion(const io_uring_cqe *cqe)
+{
+	const size_t socketIndex = io_uring_cqe_get_data64(cqe);
+	SocketContext &context = m_sockets[socketIndex];
+	if (!(cqe->flags & IORING_CQE_F_MORE)) {
+		context.receiveArmed = false; // multishot request terminated (e.g. ran out of buffers), rearm it later
+	}
+	if (IsReceiveUnsupported(cqe)) {
+		m_receiveUnsupported = true; // rearming won't help, so receiving is moved to libevent
+	}
+	if (!(cqe->flags & IORING_CQE_F_BUFFER)) {
+		return;
+	}
+
+	const uint16_t bufferId = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+	uint8_t *buffer = m_buffers.data() + bufferId * BufferSize;
+	if (cqe->res > 0)
+	{
+		io_uring_recvmsg_out *message = io_uring_recvmsg_validate(buffer, cqe->res, &context.messageHeader);
+		if (message && !(message->flags & MSG_TRUNC))
+		{
+			Datagram datagram = { NetAddress(NetAddress::AddressFamily::IPv4), nullptr, 0 };
+			const void *sourceAddr = io_uring_recvmsg_name(message);
+			if (reinterpret_cast<const sockaddr*>(sourceAddr)->sa_family == AF_INET6) 
+			{
+				datagram.source = NetAddress(NetAddress::AddressFamily::IPv6);
+				datagram.source.FromSockadr(reinterpret_cast<const sockaddr_in6*>(sourceAddr));
+			}
+			else {
+				datagram.source.FromSockadr(reinterpret_cast<const sockaddr_in*>(sourceAddr));
+			}
+
+			// payload is handled right in provided buffer, without copying
+			datagram.data = reinterpret_cast<const uint8_t*>(io_uring_recvmsg_payload(message, &context.messageHeader));
+			datagram.size = io_uring_recvmsg_payload_length(message, cqe->res, &context.messageHeader);
+			m_requestHandler.HandlePacket(*context.socket, datagram);
+		}
+	}
+	RecycleBuffer(bufferId);
+}
+
+void UringIoBackend::RecycleBuffer(uint16_t bufferId)
+{
+	uint8_t *buffer = m_buffers.data() + bufferId * BufferSize;
+	io_uring_buf_ring_add(m_bufferRing, buffer, BufferSize, bufferId, io_uring_buf_ring_mask(BufferCount), m_recycledBuffers);
+	m_recycledBuffers += 1;
+}
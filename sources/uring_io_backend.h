@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2024 SNMetamorph
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+*/
+
+#pragma once
+#include "io_backend.h"
+#include "libevent_io_backend.h"
+#include <liburing.h>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+// receives datagrams with multishot recvmsg into provided buffers ring, so kernel writes 
+// packets straight to memory that handler reads from, without recvfrom call per wakeup.
+// libevent is notified about completions through eventfd registered in ring.
+class UringIoBackend : public IoBackend
+{
+public:
+	UringIoBackend(ev::EventBase &eventBase,
+		RequestHandler &requestHandler,
+		const ConfigData &configData,
+		const std::vector<std::shared_ptr<Socket>> &sockets);
+	~UringIoBackend() override;
+
+	Type GetType() const override { return Type::IoUring; }
+
+private:
+	static constexpr uint32_t RingEntries = 64;
+	static constexpr uint32_t BufferCount = 512;
+	static constexpr uint16_t BufferGroup = 0;
+	static constexpr size_t BufferSize = sizeof(io_uring_recvmsg_out) + NetAddress::MaxSockaddrLength + Socket::MaxDatagramSize;
+	static constexpr long long ProbeTimeout = 10000000; // in nanoseconds
+
+	struct SocketContext
+	{
+		std::shared_ptr<Socket> socket;
+		msghdr messageHeader;
+		bool receiveArmed;
+	};
+
+	void Initialize(ev::EventBase &eventBase);
+	void Shutdown();
+	void ArmReceive(size_t socketIndex);
+	void CheckReceiveSupport();
+	void CompletionCallback();
+	void HandleCompletion(const io_uring_cqe *cqe);
+	void RecycleBuffer(uint16_t bufferId);
+	void SwitchToFallback();
+	static bool IsReceiveUnsupported(const io_uring_cqe *cqe);
+
+	ev::EventBase &m_eventBase;
+	RequestHandler &m_requestHandler;
+	const ConfigData &m_configData;
+	bool m_ringInitialized;
+	bool m_receiveUnsupported;
+	io_uring m_ring;
+	io_uring_buf_ring *m_bufferRing;
+	std::vector<uint8_t> m_buffers;
+	uint32_t m_recycledBuffers;
+	std::vector<SocketContext> m_sockets;
+	int m_eventDescriptor;
+	std::unique_ptr<ev::Event> m_completionEvent;
+	std::unique_ptr<LibeventIoBackend> m_fallbackBackend; // in case multishot recvmsg fails after start
+};
@@ -17,11 +17,39 @@ GNU General Public License for more details.
 #include <cstdio>
 #include <vector>
 #include <string_view>
+#include <optional>
+#include <charconv>
+#include <system_error>
 
 namespace Utils
 {
 	std::vector<std::string_view> Tokenize(std::string_view input, std::string_view token);
 
+	// parses integer from beginning of text, rest of text is ignored. there is no allocations 
+	// and locale dependency, so it's fine to use it right in packets parsing.
+	// leading whitespace and plus sign are skipped, like scanf-style parsing did
+	template<class T> std::optional<T> ParseInteger(std::string_view text, int base = 10, size_t *parsedLength = nullptr)
+	{
+		const char *begin = text.data();
+		const char *textEnd = text.data() + text.size();
+		while (begin < textEnd && (*begin == ' ' || (*begin >= '\t' && *begin <= '\r'))) {
+			begin++;
+		}
+		if (begin < textEnd && *begin == '+' && (begin + 1 == textEnd || begin[1] != '-')) {
+			begin++;
+		}
+
+		T value;
+		auto [end, error] = std::from_chars(begin, textEnd, value, base);
+		if (error != std::errc()) {
+			return std::nullopt;
+		}
+		if (parsedLength) {
+			*parsedLength = end - text.data();
+		}
+		return value;
+	}
+
 	template<typename... T> void Log(fmt::format_string<T...> fmt, T&&... args) 
 	{
 		fmt::print(fmt, std::forward<T>(args)...);
@@ -13,8 +13,8 @@ GNU General Public License for more details.
 */
 
 #include "version_info.h"
+#include "utils.h"
 #include <string_view>
-#include <scn/scan.h>
 #include <fmt/core.h>
 
 VersionInfo::VersionInfo() :
@@ -87,25 +87,28 @@ bool VersionInfo::operator>=(const VersionInfo &rhs) const
 
 std::optional<VersionInfo> VersionInfo::Parse(std::string_view text)
 {
-	auto s1 = scn::scan<uint32_t, uint32_t>(text, "{}.{}");
-	if (s1)
-	{
-		auto [major, minor] = s1->values();
-		auto s2 = scn::scan<uint32_t>(s1->range(), ".{}");
-		
-		VersionInfo result;
-		if (s2.has_value()) {
-			result.patch = s2->value();
-		}
-		else {
-			result.patch = std::nullopt;
-		}
+	// format is major.minor with optional .patch, anything after it is ignored
+	size_t length;
+	auto major = Utils::ParseInteger<uint32_t>(text, 10, &length);
+	if (!major.has_value() || length >= text.size() || text[length] != '.') {
+		return std::nullopt;
+	}
+
+	text.remove_prefix(length + 1);
+	auto minor = Utils::ParseInteger<uint32_t>(text, 10, &length);
+	if (!minor.has_value()) {
+		return std::nullopt;
+	}
 
-		result.major = major;
-		result.minor = minor;
-		return result;
+	text.remove_prefix(length);
+	VersionInfo result;
+	result.major = major.value();
+	result.minor = minor.value();
+	result.patch = std::nullopt;
+	if (!text.empty() && text[0] == '.') {
+		result.patch = Utils::ParseInteger<uint32_t>(text.substr(1));
 	}
-	return std::nullopt;
+	return result;
 }
 
 std::string VersionInfo::ToString() const